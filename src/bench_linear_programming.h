@@ -0,0 +1,178 @@
+/*
+ * bench_linear_programming.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  A replay benchmark for the feasibility checks. RecordLinearProgramming()
+ *  builds an IntegerTree while a LinearProgrammingRecorder logs every check
+ *  made, and BenchmarkLinearProgrammingReplay() solves the checks of such a
+ *  log again, either with a LinearProgrammingContext that follows the logged
+ *  pushes and pops (so all of its shortcuts apply), or from scratch with one
+ *  backend, as IsFeasibleSequence() would. It reports the throughput and the
+ *  checks whose verdict differs from the logged one.
+ */
+
+#ifndef BENCH_LINEAR_PROGRAMMING_H_
+#define BENCH_LINEAR_PROGRAMMING_H_
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench_multiplication_table.h"
+#include "dense_simplex.h"
+#include "feasibility_backend.h"
+#include "integer_tree.h"
+#include "linear_programming.h"
+#include "linear_programming_recorder.h"
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace Platt {
+
+enum ReplayMethod {
+  REPLAY_CONTEXT,
+  REPLAY_DENSE,
+#ifndef PLATT_WITHOUT_CLP
+  REPLAY_CLP,
+#endif
+};
+
+void RecordLinearProgramming(const string& filename, unsigned int height) {
+  LinearProgrammingRecorder recorder(filename);
+  IntegerTree tree(height);
+}
+
+// Solves the check of candidates[k] after sequence on backend, from scratch.
+bool SolveReplayedCheck(const vector<Factorization>& sequence,
+                        unsigned int num_primes, size_t k,
+                        const vector<Factorization>& candidates,
+                        FeasibilityBackend* backend) {
+  backend->Clear();
+  for (unsigned int j = 0; j < num_primes; ++j)
+    backend->AddColumn();
+  vector<int> columns;
+  vector<double> elements;
+  auto add_row = [&] (const Factorization& f1, const Factorization& f2) {
+    columns.clear();
+    elements.clear();
+    for (auto p : GetConstraintCoefficients(f1, f2)) {
+      columns.push_back(p.first);
+      elements.push_back(p.second);
+    }
+    backend->AddRow(columns.size(), columns.data(), elements.data(), true);
+  };
+  for (size_t i = 0; i + 1 < sequence.size(); ++i)
+    add_row(sequence[i], sequence[i + 1]);
+  add_row(sequence.back(), candidates[k]);
+  for (size_t j = 0; j < candidates.size(); ++j) {
+    if (j != k)
+      add_row(candidates[k], candidates[j]);
+  }
+  return backend->Solve();
+}
+
+void BenchmarkLinearProgrammingReplay(const string& filename,
+                                      ReplayMethod method) {
+  LinearProgrammingLog log(filename);
+  if (!log.IsValid()) {
+    cout << filename << " is not a linear programming log." << endl;
+    return;
+  }
+  unique_ptr<FeasibilityBackend> backend;
+  string name = "context";
+  if (method == REPLAY_DENSE) {
+    backend.reset(new DenseSimplexBackend());
+    name = "dense";
+  }
+#ifndef PLATT_WITHOUT_CLP
+  if (method == REPLAY_CLP) {
+    backend.reset(NewClpBackend());
+    name = "clp";
+  }
+#endif
+  // The state of each logged context.
+  struct ReplayedContext {
+    vector<Factorization> sequence;
+    unsigned int num_primes = 0;
+    unique_ptr<LinearProgrammingContext> context;
+  };
+  std::map<unsigned int, ReplayedContext> contexts;
+
+  LinearProgrammingRecord record;
+  size_t num_checks = 0;
+  size_t disagreements = 0;
+  double logged_ms = 0;
+  vector<bool> feasible;
+  vector<const Factorization*> candidates;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  while (log.Read(&record)) {
+    ReplayedContext& replayed = contexts[record.context];
+    if (method == REPLAY_CONTEXT && replayed.context == nullptr)
+      replayed.context.reset(new LinearProgrammingContext());
+    if (record.type == PUSH_RECORD) {
+      replayed.sequence.push_back(record.factorizations[0]);
+      replayed.num_primes = record.num_primes;
+      if (replayed.context != nullptr)
+        replayed.context->Push(record.factorizations[0], record.num_primes);
+      continue;
+    }
+    if (record.type == POP_RECORD) {
+      replayed.sequence.pop_back();
+      replayed.num_primes = record.num_primes;
+      if (replayed.context != nullptr)
+        replayed.context->Pop(record.num_primes);
+      continue;
+    }
+    // A check. Its rows may use the primes of the candidates too.
+    unsigned int num_primes = replayed.num_primes;
+    candidates.clear();
+    for (const Factorization& f : record.factorizations) {
+      num_primes = max(num_primes, (unsigned int) f.GetMaxPrime() + 1);
+      candidates.push_back(&f);
+    }
+    feasible.assign(record.outcomes.size(), false);
+    if (replayed.context == nullptr) {
+      for (size_t k = 0; k < record.outcomes.size(); ++k) {
+        feasible[k] = SolveReplayedCheck(replayed.sequence, num_primes, k,
+                                         record.factorizations, backend.get());
+      }
+    } else if (record.outcomes.size() == candidates.size()) {
+      replayed.context->IsFeasibleBatch(candidates, &feasible);
+    } else {
+      vector<const Factorization*> others(candidates.begin() + 1,
+                                          candidates.end());
+      feasible[0] = replayed.context->IsFeasible(*candidates[0], others);
+    }
+    for (size_t k = 0; k < record.outcomes.size(); ++k) {
+      num_checks++;
+      logged_ms += record.outcomes[k].nanoseconds / 1e6;
+      if (feasible[k] != record.outcomes[k].feasible)
+        disagreements++;
+    }
+  }
+  double replay_ms = MillisecondsSince(begin);
+
+  cout << name << "\t" << num_checks << " checks in " << replay_ms << " ms ("
+       << (replay_ms > 0 ? num_checks / replay_ms * 1000 : 0) << " per second)"
+       << "\tlogged solve time " << logged_ms << " ms"
+       << "\t" << disagreements << " disagreements" << endl;
+}
+
+void BenchmarkLinearProgrammingReplay(const string& filename) {
+  BenchmarkLinearProgrammingReplay(filename, REPLAY_CONTEXT);
+  BenchmarkLinearProgrammingReplay(filename, REPLAY_DENSE);
+#ifndef PLATT_WITHOUT_CLP
+  BenchmarkLinearProgrammingReplay(filename, REPLAY_CLP);
+#endif
+}
+
+}  // namespace Platt
+
+#endif /* BENCH_LINEAR_PROGRAMMING_H_ */
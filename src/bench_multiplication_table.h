@@ -0,0 +1,80 @@
+/*
+ * bench_multiplication_table.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  A microbenchmark for the MultiplicationTable class. For each height the
+ *  table is grown along the path of the natural numbers down the tree, and then
+ *  we time cycles of GetCandidates(), PushComposite() and PopComposite() at the
+ *  bottom of that path, as a tree builder would make them. Both storage modes
+ *  are measured.
+ */
+
+#ifndef BENCH_MULTIPLICATION_TABLE_H_
+#define BENCH_MULTIPLICATION_TABLE_H_
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "multiplication_table.h"
+#include "test_multiplication_table.h"
+using std::cout;
+using std::endl;
+using std::vector;
+
+namespace Platt {
+
+// Returns the number of milliseconds since begin.
+double MillisecondsSince(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - begin).count();
+}
+
+void BenchmarkMultiplicationTable(TableStorage storage, unsigned int height,
+                                  unsigned int cycles) {
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  MultiplicationTable table(storage);
+  table.Reserve(height);
+  vector<unsigned int> primes(1, 2);
+  vector<Candidate> pushed;
+  // The first row holds 1 and 2; the root of the tree is 2.
+  for (unsigned int n = 3; n < height + 3; ++n) {
+    if (!PushNaturalNumber(n, &table, &primes, &pushed)) {
+      cout << n << " was not a candidate!" << endl;
+      return;
+    }
+  }
+  double build_ms = MillisecondsSince(begin);
+
+  begin = std::chrono::steady_clock::now();
+  size_t candidate_count = 0;
+  for (unsigned int i = 0; i < cycles; ++i) {
+    vector<Candidate> candidates = table.GetCandidates();
+    candidate_count += candidates.size();
+    for (const Candidate& c : candidates) {
+      table.PushComposite(c);
+      table.PopComposite(c);
+    }
+  }
+  double cycles_ms = MillisecondsSince(begin);
+
+  cout << (storage == IMPLICIT_TABLE ? "implicit" : "explicit")
+       << "\theight " << height
+       << "\tbuild " << build_ms << " ms"
+       << "\t" << cycles << " cycles " << cycles_ms << " ms"
+       << " (" << candidate_count << " candidates)" << endl;
+}
+
+void BenchmarkMultiplicationTable() {
+  const unsigned int HEIGHTS[] = {50, 100, 200, 300, 400, 500};
+  const unsigned int CYCLES = 100;
+  for (unsigned int height : HEIGHTS) {
+    BenchmarkMultiplicationTable(IMPLICIT_TABLE, height, CYCLES);
+    BenchmarkMultiplicationTable(EXPLICIT_TABLE, height, CYCLES);
+  }
+}
+
+}  // namespace Platt
+
+#endif /* BENCH_MULTIPLICATION_TABLE_H_ */
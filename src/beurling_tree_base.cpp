@@ -8,6 +8,7 @@
  */
 
 #include "beurling_tree_base.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 using std::ios;
@@ -15,23 +16,17 @@ using std::endl;
 
 namespace Platt {
 
-// Initialize static members.
-BeurlingTreeBase* BeurlingTreeBase::PcfBase::tree_ptr = nullptr;
-vector< vector<unsigned int> > BeurlingTreeBase::PcfBase::triangle
-    = vector< vector<unsigned int> >();
-unsigned int BeurlingTreeBase::PcfBase::prime_count = 0;
-int BeurlingTreeBase::PcfBase::height = -1;
-ofstream BeurlingTreeBase::SerialBase::out_file;
-
 void BeurlingTreeBase::InitDefault() {
   // Init root node
-  tree.Init(Factorization(0));
+  tree.Init(table.Intern(Factorization(0)));
   graphviz_node_counter = 0;
 }
 
 void BeurlingTreeBase::InitToHeight(unsigned int height) {
   // Init root node
-  tree.Init(Factorization(0));
+  tree.Init(table.Intern(Factorization(0)));
+  table.Reserve(height);
+  tree.ReserveDepth(height + 1);
   RecursiveBuild(height, tree.GetRoot());
 }
 
@@ -43,29 +38,49 @@ void BeurlingTreeBase::InitFromFile(string filename) {
   getline(in, line);
   // line.pop_back() avoided due to MinGW compatibility issues.
   line.erase(line.size()-1);  // line.pop_back();
-  tree.Init(line);
-  Node<Factorization>* root = tree.GetRoot();
+  tree.Init(table.Intern(Factorization(line)));
+  Node<FactorizationId>* root = tree.GetRoot();
 
-  // Recurse on root
-  RecursiveSerialBuild(&in, root);
+  SerialBuild(&in, root);
 
   in.close();
 }
 
-void BeurlingTreeBase::RecursiveSerialBuild(ifstream* in, Node<Factorization>* n) {
+void BeurlingTreeBase::SerialBuild(ifstream* in, Node<FactorizationId>* root) {
+  // The nodes from root to the one whose children are being read. Each line
+  // "#,#[" opens a child of the last of them, and each "]" closes it.
+  vector< Node<FactorizationId>* > open_nodes(1, root);
+  size_t depth = 1;
   string line;
-  getline(*in, line);
+  while (!open_nodes.empty() && getline(*in, line)) {
+    // line.pop_back() and line.back() avoided due to MinGW compatibility
+    // issues.
+    if (!line.empty() && /*line.back() == '['*/line[line.size()-1] == '[') {
+      line.erase(line.size()-1);  // line.pop_back();
+      open_nodes.push_back(tree.AddChild(
+          open_nodes.back(), table.Intern(Factorization(line))));
+      depth = std::max(depth, open_nodes.size());
+    } else {  // line.back was "]"
+      open_nodes.pop_back();
+    }
+  }
+  tree.ReserveDepth(depth);
+}
 
-  // line.pop_back() and line.back() avoided due to MinGW compatibility issues.
-  while(in->good() && /*line.back() == '['*/line[line.size()-1] == '[') {
-    line.erase(line.size()-1);  // line.pop_back();
-    Node<Factorization>* child = new Node<Factorization>(line);
-    n->Add(child);
-    RecursiveSerialBuild(in, child);
+const Factorization& BeurlingTreeBase::GetFactorization(
+    const Node<FactorizationId>* n) const {
+  return table.GetFactorization(n->GetData());
+}
 
-    getline(*in, line);
-  }
-  // else line.back was "]", or at end of file
+// The nodes hold ids, whose order depends on the order in which the
+// factorizations were interned, so the factorizations are compared instead.
+Node<FactorizationId>* BeurlingTreeBase::AddChildInOrder(
+    Node<FactorizationId>* parent, FactorizationId id) {
+  return tree.InsertChild(parent, id,
+      [this] (FactorizationId lhs, FactorizationId rhs) {
+        return Factorization::LexicographicallyLess(
+            table.GetFactorization(lhs), table.GetFactorization(rhs));
+      });
 }
 
 // The Tree class handles destruction on its own
@@ -73,12 +88,10 @@ BeurlingTreeBase::~BeurlingTreeBase() {}
 
 //void BeurlingTreeBase::NextLevel() {}
 void BeurlingTreeBase::SerializeToFile(string filename) {
-  SerialBase::SetFileStream(filename);
-  SerialRec1 rec1;
-  SerialRec2 rec2;
-  SerialLeaf leaf;
-  tree.DepthFirst(&rec1, &rec2, &leaf);
-  SerialBase::CloseFileStream();
+  ofstream out_file(filename.c_str());
+  SerialVisitor visitor(this, &out_file);
+  tree.DepthFirst(visitor);
+  out_file.close();
 }
 
 void BeurlingTreeBase::ExportAsDot(string filename) {
@@ -86,37 +99,26 @@ void BeurlingTreeBase::ExportAsDot(string filename) {
   graphviz_node_counter = 0;
   graph_file.open(filename.c_str());
 
-  Node<Factorization>* root_node = tree.GetRoot();
-  unsigned int root_graphviz_number = graphviz_node_counter;
+  Node<FactorizationId>* root_node = tree.GetRoot();
 
   graph_file << "digraph G {" << endl;
   graph_file << '\t' <<  graphviz_node_counter
-             << " [label=\"" << root_node->GetData().ToDotString() << "\"];"
+             << " [label=\"" << GetFactorization(root_node).ToDotString()
+             << "\"];"
              << endl;
-  RecursiveExportAsDot(root_node,  root_graphviz_number);
+  DotVisitor visitor(this);
+  tree.DepthFirst(visitor);
   graph_file << "}" ;
   graph_file.close();
 }
 
-void BeurlingTreeBase::RecursiveExportAsDot(Node<Factorization>* current_node,
-                                       unsigned int current_graphviz_number) {
-  vector< Node<Factorization>* > children = current_node->GetChildren();
-  for (Node<Factorization>* child : children){
-    graphviz_node_counter++;
-    // this is the child's id:
-    unsigned int child_graphviz_number = graphviz_node_counter;
-    // Add link of current_node to child_node
-    AddToGraphvizFile(current_graphviz_number, child_graphviz_number, child);
-    RecursiveExportAsDot(child, child_graphviz_number);
-  }
-}
-
 void BeurlingTreeBase::AddToGraphvizFile(unsigned int parent_graphviz_number,
                                     unsigned int child_graphviz_number,
-                                    Node<Factorization>* child){
+                                    Node<FactorizationId>* child){
   // Give a label to the child
   graph_file << '\t' <<  child_graphviz_number
-             << " [label=\"" << child->GetData().ToDotString() << "\"];"
+             << " [label=\"" << GetFactorization(child).ToDotString()
+             << "\"];"
              << endl;
 
   // Link the child to the parent
@@ -128,57 +130,83 @@ void BeurlingTreeBase::AddToGraphvizFile(unsigned int parent_graphviz_number,
 // Returns a number triangle giving the frequencies of values of the prime
 // counting function at different heights of the tree.
 vector< vector<unsigned int> > BeurlingTreeBase::GetTriangle() {
-  PcfBase::SetTree(this);
-  PcfBase::ResetTriangle();
-  PcfRec1 rec1;
-  PcfRec2 rec2;
-  PcfLeaf leaf;
-  tree.DepthFirst(&rec1, &rec2, &leaf);
-  return PcfBase::GetTriangle();
+  PcfVisitor visitor(this);
+  tree.DepthFirst(visitor);
+  return visitor.GetTriangle();
 }
 
-void BeurlingTreeBase::PcfRec1::operator() (Node<Factorization>* n) {
+void BeurlingTreeBase::PcfVisitor::Count(bool is_prime) {
   height++;
   while (triangle.size() < (unsigned int)height+1)
     triangle.push_back(vector<unsigned int>());
-  if (n->GetData().IsPrime())
+  if (is_prime)
     prime_count++;
   while (triangle[height].size() < prime_count)
     triangle[height].push_back(0);
   triangle[height][prime_count-1]++;
 }
 
-void BeurlingTreeBase::PcfRec2::operator() (Node<Factorization>* n) {
+void BeurlingTreeBase::PcfVisitor::Enter(Node<FactorizationId>* n) {
+  Count(tree_ptr->GetFactorization(n).IsPrime());
+}
+
+void BeurlingTreeBase::PcfVisitor::Leave(Node<FactorizationId>* n) {
   height--;
-  if (n->GetData().IsPrime())
+  if (tree_ptr->GetFactorization(n).IsPrime())
     prime_count--;
 }
 
-void BeurlingTreeBase::PcfLeaf::operator() (Node<Factorization>* n) {
-  height++;
-  while (triangle.size() < (unsigned int)height+1)
-    triangle.push_back(vector<unsigned int>());
-  if (n->GetData().IsPrime())
-    prime_count++;
-  while (triangle[height].size() < prime_count)
-    triangle[height].push_back(0);
-  triangle[height][prime_count-1]++;
-
+void BeurlingTreeBase::PcfVisitor::Leaf(Node<FactorizationId>* n) {
+  // The factorization is looked up once, for both steps.
+  bool is_prime = tree_ptr->GetFactorization(n).IsPrime();
+  Count(is_prime);
   height--;
-  if (n->GetData().IsPrime())
+  if (is_prime)
     prime_count--;
 }
 
-void BeurlingTreeBase::SerialRec1::operator() (Node<Factorization>* n) {
-  out_file << n->GetData().ToSerialString() << "[\n";
+void BeurlingTreeBase::SerialVisitor::Enter(Node<FactorizationId>* n) {
+  *out_file << tree_ptr->GetFactorization(n).ToSerialString() << "[\n";
+}
+
+void BeurlingTreeBase::SerialVisitor::Leave(Node<FactorizationId>* /*n*/) {
+  *out_file << "]\n";
+}
+
+void BeurlingTreeBase::SerialVisitor::Leaf(Node<FactorizationId>* n) {
+  *out_file << tree_ptr->GetFactorization(n).ToSerialString() << "[\n"
+            << "]\n";
 }
 
-void BeurlingTreeBase::SerialRec2::operator() (Node<Factorization>* n) {
-  out_file << "]\n";
+void BeurlingTreeBase::DotVisitor::Add(Node<FactorizationId>* n) {
+  unsigned int number = ++tree_ptr->graphviz_node_counter;
+  tree_ptr->AddToGraphvizFile(path_numbers.back(), number, n);
+  path_numbers.push_back(number);
+}
+
+void BeurlingTreeBase::DotVisitor::Enter(Node<FactorizationId>* n) {
+  // The root is labeled by ExportAsDot().
+  if (path_numbers.empty())
+    path_numbers.push_back(tree_ptr->graphviz_node_counter);
+  else
+    Add(n);
+}
+
+void BeurlingTreeBase::DotVisitor::Leave(Node<FactorizationId>* /*n*/) {
+  path_numbers.pop_back();
+}
+
+void BeurlingTreeBase::DotVisitor::Leaf(Node<FactorizationId>* n) {
+  if (!path_numbers.empty()) {
+    Add(n);
+    path_numbers.pop_back();
+  }
 }
 
-void BeurlingTreeBase::SerialLeaf::operator() (Node<Factorization>* n) {
-  out_file << n->GetData().ToSerialString() << "[\n" << "]\n";
+// Counts of the linear programming work done while building the tree.
+const LinearProgrammingStats&
+BeurlingTreeBase::GetLinearProgrammingStats() const {
+  return table.GetLinearProgrammingStats();
 }
 
 }  // namespace Platt
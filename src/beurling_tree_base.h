@@ -24,85 +24,90 @@ namespace Platt {
 
 class BeurlingTreeBase {
  protected:
-  Tree<Factorization> tree;
+  // The nodes of the tree store ids of factorizations in the table's
+  // FactorizationPool.
+  Tree<FactorizationId> tree;
   MultiplicationTable table;
 
   // Members used for creating a Graphviz file
   unsigned int graphviz_node_counter;   //
   ofstream graph_file;                  //
 
-  virtual void RecursiveBuild(unsigned int height, Node<Factorization>* n) = 0;
-  void RecursiveSerialBuild(ifstream* in, Node<Factorization>* n);
-  void RecursiveExportAsDot(Node<Factorization>* current_node,
-                            unsigned int current_graphviz_number);
+  virtual void RecursiveBuild(unsigned int height, Node<FactorizationId>* n) = 0;
+  // Reads the descendants of root from a serialization.
+  void SerialBuild(ifstream* in, Node<FactorizationId>* root);
   void AddToGraphvizFile(unsigned int parent_graphviz_number,
                          unsigned int child_graphviz_number,
-                         Node<Factorization>* child);
+                         Node<FactorizationId>* child);
   // Initialization functions to be used in the constructors of the child
   // classes.
   void InitDefault();
   void InitToHeight(unsigned int height);
   void InitFromFile(string filename);
- public:
-  /* We declare some functor classes. One set is used for creating a triangle
-   * of prime counting function (pcf) values. The other is used for
-   * serialization.
+  // Looks up the factorization stored in a node of the tree.
+  const Factorization& GetFactorization(const Node<FactorizationId>* n) const;
+  // Adds a child holding id to parent, keeping the children in the
+  // lexicographic order of their factorizations, the order in which they are
+  // serialized and exported.
+  Node<FactorizationId>* AddChildInOrder(Node<FactorizationId>* parent,
+                                         FactorizationId id);
+
+  /* We declare some visitor classes for Tree::DepthFirst(). One is used for
+   * creating a triangle of prime counting function (pcf) values. The others
+   * are used for serialization and for creating a Graphviz file.
    */
-  class PcfBase {
-   protected:
-    static BeurlingTreeBase* tree_ptr;
-    static vector< vector<unsigned int> > triangle;
-    static unsigned int prime_count;
+  class PcfVisitor {
+   private:
+    const BeurlingTreeBase* tree_ptr;
+    vector< vector<unsigned int> > triangle;
+    unsigned int prime_count;
     // Refers to height of triangle. Will correspond to height+1 of the tree.
-    static int height;
-
-   public:
-    static void SetTree(BeurlingTreeBase* in) {tree_ptr = in;}
-    static void ResetTriangle() {triangle.clear();}
-    static vector< vector<unsigned int> > GetTriangle() {return triangle;}
-  };
-
-  class PcfRec1 : public PcfBase {
-   public:
-    void operator() (Node<Factorization>* n);
-  };
+    int height;
 
-  class PcfRec2 : public PcfBase {
-   public:
-    void operator() (Node<Factorization>* n);
-  };
+    // Counts a node as the next one down the current path.
+    void Count(bool is_prime);
 
-  class PcfLeaf : public PcfBase {
    public:
-    void operator() (Node<Factorization>* n);
+    explicit PcfVisitor(const BeurlingTreeBase* in)
+        : tree_ptr(in), prime_count(0), height(-1) {}
+    void Enter(Node<FactorizationId>* n);
+    void Leave(Node<FactorizationId>* n);
+    void Leaf(Node<FactorizationId>* n);
+    const vector< vector<unsigned int> >& GetTriangle() const {
+      return triangle;
+    }
   };
 
-  class SerialBase {
-   protected:
-    //static BeurlingTreeBase* tree_ptr;
-    static ofstream out_file;
+  class SerialVisitor {
+   private:
+    const BeurlingTreeBase* tree_ptr;
+    ofstream* out_file;
 
    public:
-    //static void SetTree(BeurlingTreeBase* in) {tree_ptr = in;}
-    static void SetFileStream(string s) {out_file.open(s.c_str());}
-    static void CloseFileStream() {out_file.close();}
+    SerialVisitor(const BeurlingTreeBase* in, ofstream* out)
+        : tree_ptr(in), out_file(out) {}
+    void Enter(Node<FactorizationId>* n);
+    void Leave(Node<FactorizationId>* n);
+    void Leaf(Node<FactorizationId>* n);
   };
 
-  class SerialRec1 : public SerialBase {
-   public:
-    void operator() (Node<Factorization>* n);
-  };
+  class DotVisitor {
+   private:
+    BeurlingTreeBase* tree_ptr;
+    // The Graphviz numbers of the nodes from the root to the current one.
+    vector<unsigned int> path_numbers;
 
-  class SerialRec2 : public SerialBase {
-   public:
-    void operator() (Node<Factorization>* n);
-  };
+    // Numbers n and links it to its parent.
+    void Add(Node<FactorizationId>* n);
 
-  class SerialLeaf : public SerialBase {
    public:
-    void operator() (Node<Factorization>* n);
+    explicit DotVisitor(BeurlingTreeBase* in) : tree_ptr(in) {}
+    void Enter(Node<FactorizationId>* n);
+    void Leave(Node<FactorizationId>* n);
+    void Leaf(Node<FactorizationId>* n);
   };
 
+ public:
   virtual ~BeurlingTreeBase();
 
   // virtual void NextLevel();
@@ -120,6 +125,8 @@ class BeurlingTreeBase {
   // Returns a number triangle giving the frequencies of values of the prime
   // counting function at different heights of the tree.
   vector< vector<unsigned int> > GetTriangle();
+  // Counts of the linear programming work done while building the tree.
+  const LinearProgrammingStats& GetLinearProgrammingStats() const;
 };
 
 }  // namespace Platt
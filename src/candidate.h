@@ -8,6 +8,10 @@
  *  the table and the tree. The Factorizaion is used by both the table and the
  *  table and the tree. The entries are used by just the table.
  *
+ *  The Factorization is referred to by its id in the table's
+ *  FactorizationPool. Use MultiplicationTable::GetFactorization() to look it
+ *  up.
+ *
  *  The implementation is inlined because it is short.
  */
 
@@ -17,6 +21,7 @@
 #include <vector>
 #include <algorithm>
 #include "factorization.h"
+#include "factorization_pool.h"
 #include "compatibility.h"
 using std::vector;
 using std::sort;
@@ -25,28 +30,33 @@ namespace Platt {
 
 class Candidate {
  private:
-  Factorization factors;
+  FactorizationId factorization_id;
   vector< Tuple > entries;
 
  public:
-  Candidate() {}
-  Candidate(const Factorization& f, const Tuple& t) {
-    factors = f; entries.push_back(t);
+  Candidate() {factorization_id = 0;}
+  explicit Candidate(FactorizationId f) {factorization_id = f;}
+  Candidate(FactorizationId f, const Tuple& t) {
+    factorization_id = f; entries.push_back(t);
   }
-  Candidate(const Candidate& c) {entries = c.entries; factors = c.factors;}
-  void SetFactors(const Factorization& f) {factors = f;}
-  void AddEntry(Tuple t) {
+  // The implicit copy and move constructors and assignment operators are used.
+  void SetFactorizationId(FactorizationId f) {factorization_id = f;}
+  void AddEntry(const Tuple& t) {
     entries.push_back(t);
   }
+  // Adds the cell (row, column) without constructing a temporary Tuple.
+  void EmplaceEntry(unsigned int row, unsigned int column) {
+    entries.emplace_back(row, column);
+  }
 
-  Factorization GetFactors() const {return factors;}
-  vector<Tuple> GetEntries() const {return entries;}
+  FactorizationId GetFactorizationId() const {return factorization_id;}
+  const vector<Tuple>& GetEntries() const {return entries;}
 
   /* TODO: Figure out const issues here. This issue propagates upwards since
    * calling functions can't use const.
    */
   bool operator== (/*const*/ Candidate& rhs) /*const*/ {
-    if (factors != rhs.factors)
+    if (factorization_id != rhs.factorization_id)
       return false;
     if (entries.size() != rhs.entries.size())
       return false;
@@ -62,9 +72,9 @@ class Candidate {
   bool operator!= (/*const*/ Candidate& rhs) /*const*/ {
       return !(*this == rhs);
   }
-  string DebugString() const {
+  string DebugString(const FactorizationPool& pool) const {
     string out;
-    out += "Factorization: " + factors.ToDotString() + "\n";
+    out += "Factorization: " + pool.Get(factorization_id).ToDotString() + "\n";
     out += "Cells:\n";
     for (Tuple t : entries) {
       out += "(" + to_string(t.first) + "," + to_string(t.second) + ") ";
@@ -0,0 +1,126 @@
+/*
+ * clp_backend.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the FeasibilityBackend that uses the Coin-Or CLP library. Nothing
+ *  here is built when PLATT_WITHOUT_CLP is defined.
+ */
+
+#include <vector>
+#include "feasibility_backend.h"
+#ifndef PLATT_WITHOUT_CLP
+#include "ClpSimplex.hpp"
+#include "CoinHelperFunctions.hpp"
+#endif
+using std::vector;
+
+namespace Platt {
+
+#ifndef PLATT_WITHOUT_CLP
+
+namespace {
+
+// Returns the LinearProgrammingException for a model for which CLP has failed
+// to either find a feasible solution or prove that a feasible solution does
+// not exist.
+LinearProgrammingException SolverFailure(const ClpSimplex& model) {
+  string error_string = string("Linear Programming Exception: CLP has failed"
+      " to either find a feasible solution or prove that a feasible solution"
+      " does not exist.");
+  string debug_string = "";
+  if (model.isPrimalObjectiveLimitReached()) {
+    debug_string += "Primal Objective Limit Reached\n";
+  }
+  if (model.isIterationLimitReached()) {
+    debug_string += "Iteration Limit Reached\n";
+  }
+  if (model.isAbandoned()) {
+    debug_string += "Problem \"Abandoned\" by CLP\n";
+  }
+  return LinearProgrammingException(error_string, debug_string);
+}
+
+// A disabled row gets the lower bound -COIN_DBL_MAX, and an enabled one
+// epsilon. Every column has the cost 1, so that the optimal solution is a
+// vertex, but only feasibility matters to us.
+class ClpBackend : public FeasibilityBackend {
+ private:
+  ClpSimplex model;
+  vector<int> rows_to_delete;
+
+ public:
+  ClpBackend() {
+    model.setLogLevel(0);  // Supress console output.
+    // Bit 32 makes CLP keep the infeasibility ray of a solve (see
+    // ClpModel::specialOptions()), which GetInfeasibilityRay() returns.
+    model.setSpecialOptions(model.specialOptions() | 32);
+  }
+  void Clear() override {
+    RemoveRowsFrom(0);
+    while (model.numberColumns() > 0)
+      RemoveLastColumn();
+  }
+  int NumRows() const override {return model.numberRows();}
+  int NumColumns() const override {return model.numberColumns();}
+  void AddColumn() override {
+    model.addColumn(0, nullptr, nullptr, 0.0, COIN_DBL_MAX, 1.0);
+  }
+  void RemoveLastColumn() override {
+    int last_column = model.numberColumns() - 1;
+    model.deleteColumns(1, &last_column);
+  }
+  void AddRow(int n, const int* columns, const double* elements,
+              bool enabled) override {
+    model.addRow(n, columns, elements,
+                 enabled ? CONSTRAINT_EPSILON : -COIN_DBL_MAX, COIN_DBL_MAX);
+  }
+  void SetRowEnabled(int row, bool enabled) override {
+    model.setRowLower(row, enabled ? CONSTRAINT_EPSILON : -COIN_DBL_MAX);
+  }
+  void RemoveRowsFrom(int first_row) override {
+    rows_to_delete.clear();
+    for (int row = first_row; row < model.numberRows(); ++row)
+      rows_to_delete.push_back(row);
+    if (!rows_to_delete.empty())
+      model.deleteRows(rows_to_delete.size(), rows_to_delete.data());
+  }
+  // The objective and the column bounds never change, so the basis of the
+  // last solve stays dual feasible and the dual simplex method can start from
+  // it.
+  bool Solve() override {
+    model.dual();
+    if (model.isProvenOptimal())
+      return true;
+    if (model.isProvenPrimalInfeasible())
+      return false;
+    throw(SolverFailure(model));
+  }
+  const double* GetSolution() const override {
+    return model.getColSolution();
+  }
+  // CLP gives the dual ray with the opposite sign to its row duals, which are
+  // nonnegative for our >= rows (OsiClpSolverInterface::getDualRays() negates
+  // it in the same way), so it is negated into the Farkas multipliers.
+  bool GetInfeasibilityRay(vector<double>* ray) const override {
+    double* clp_ray = model.infeasibilityRay();
+    if (clp_ray == nullptr)
+      return false;
+    ray->assign(clp_ray, clp_ray + model.numberRows());
+    delete[] clp_ray;
+    for (double& y : *ray)
+      y = -y;
+    return true;
+  }
+};
+
+}  // namespace
+
+FeasibilityBackend* NewClpBackend() {
+  return new ClpBackend();
+}
+
+#endif  // PLATT_WITHOUT_CLP
+
+}  // namespace Platt
@@ -0,0 +1,228 @@
+/*
+ * dense_simplex.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares and defines the DenseSimplexBackend class, a FeasibilityBackend for
+ *  problems with few columns that needs no external library.
+ *
+ *  The constraints A x > 0, x >= 0 are homogeneous, so they can be satisfied
+ *  exactly when the matrix game A has a positive value:
+ *      v = max over distributions x of min_i (A x)_i.
+ *  With c chosen so that B = A + c has only positive entries, the value of B is
+ *  v + c > 0, and the standard linear program for the row player of B,
+ *      maximize sum z  subject to  B^T z <= 1, z >= 0,
+ *  has the optimum 1 / (v + c). Its tableau has one row per column of A (that
+ *  is, per prime) and starts from the basis of its slack variables, so no
+ *  first phase is needed and a solve only takes a few small pivots however
+ *  many rows A has. The optimal strategy of the column player, read from the
+ *  dual values, is the solution. It is scaled so that its least row is
+ *  epsilon.
+ *
+ *  Pivots follow Bland's rule, so the method cannot cycle.
+ *
+ *  Implementation is inlined in the header since it is short.
+ */
+
+#ifndef DENSE_SIMPLEX_H_
+#define DENSE_SIMPLEX_H_
+
+#include <algorithm>
+#include <vector>
+#include "feasibility_backend.h"
+using std::min;
+using std::vector;
+
+namespace Platt {
+
+class DenseSimplexBackend : public FeasibilityBackend {
+ private:
+  // A game value at most this is taken to be zero.
+  static constexpr double VALUE_TOLERANCE = 1e-11;
+  // A coefficient at most this is taken to be zero when pivoting.
+  static constexpr double PIVOT_TOLERANCE = 1e-12;
+  static const int MAX_PIVOTS = 10000;
+
+  int num_columns;
+  // The rows are stored sparsely: row r has the coefficients from
+  // row_starts[r] up to row_starts[r + 1].
+  vector<int> row_starts;
+  vector<int> row_columns;
+  vector<double> row_elements;
+  vector<bool> row_enabled;
+  vector<double> solution;
+  vector<double> ray;
+  // Scratch space for Solve().
+  vector<int> enabled_rows;
+  vector<double> game;
+  vector<double> tableau;
+  vector<int> basis;
+
+  // Fills game with the dense matrix A of the enabled rows (row-major, one row
+  // per enabled row) and returns its least entry.
+  double BuildGame() {
+    enabled_rows.clear();
+    for (int r = 0; r < NumRows(); ++r) {
+      if (row_enabled[r])
+        enabled_rows.push_back(r);
+    }
+    game.assign(enabled_rows.size() * num_columns, 0.0);
+    double least = 0;
+    for (size_t i = 0; i < enabled_rows.size(); ++i) {
+      int r = enabled_rows[i];
+      for (int k = row_starts[r]; k < row_starts[r + 1]; ++k)
+        game[i * num_columns + row_columns[k]] += row_elements[k];
+      for (int j = 0; j < num_columns; ++j)
+        least = min(least, game[i * num_columns + j]);
+    }
+    return least;
+  }
+
+ public:
+  DenseSimplexBackend() : num_columns(0), row_starts(1, 0) {}
+
+  void Clear() override {
+    num_columns = 0;
+    row_starts.assign(1, 0);
+    row_columns.clear();
+    row_elements.clear();
+    row_enabled.clear();
+  }
+  int NumRows() const override {return row_enabled.size();}
+  int NumColumns() const override {return num_columns;}
+  void AddColumn() override {num_columns++;}
+  void RemoveLastColumn() override {num_columns--;}
+  void AddRow(int n, const int* columns, const double* elements,
+              bool enabled) override {
+    row_columns.insert(row_columns.end(), columns, columns + n);
+    row_elements.insert(row_elements.end(), elements, elements + n);
+    row_starts.push_back(row_columns.size());
+    row_enabled.push_back(enabled);
+  }
+  void SetRowEnabled(int row, bool enabled) override {
+    row_enabled[row] = enabled;
+  }
+  void RemoveRowsFrom(int first_row) override {
+    row_columns.resize(row_starts[first_row]);
+    row_elements.resize(row_starts[first_row]);
+    row_starts.resize(first_row + 1);
+    row_enabled.resize(first_row);
+  }
+
+  bool Solve() override {
+    solution.assign(num_columns, 0.0);
+    ray.assign(NumRows(), 0.0);
+    double shift = 1.0 - BuildGame();
+    int m = enabled_rows.size();
+    int n = num_columns;
+    if (m == 0)
+      return true;
+    if (n == 0) {
+      ray[enabled_rows[0]] = 1;
+      return false;
+    }
+
+    // The tableau has n constraint rows and the objective row. Its columns
+    // are the m variables z, the n slack variables and the right hand side.
+    int width = m + n + 1;
+    tableau.assign((n + 1) * width, 0.0);
+    basis.resize(n);
+    for (int j = 0; j < n; ++j) {
+      for (int i = 0; i < m; ++i)
+        tableau[j * width + i] = game[i * n + j] + shift;
+      tableau[j * width + m + j] = 1;
+      tableau[j * width + width - 1] = 1;
+      basis[j] = m + j;
+    }
+    // The objective row holds the reduced costs, and minus the objective value
+    // in its last entry.
+    double* objective = &tableau[n * width];
+    for (int i = 0; i < m; ++i)
+      objective[i] = 1;
+
+    for (int pivots = 0;; ++pivots) {
+      if (pivots == MAX_PIVOTS) {
+        throw(LinearProgrammingException(
+            "Linear Programming Exception: the dense simplex method has"
+            " reached its pivot limit.", "Iteration Limit Reached\n"));
+      }
+      int entering = -1;
+      for (int k = 0; k < width - 1 && entering < 0; ++k) {
+        if (objective[k] > PIVOT_TOLERANCE)
+          entering = k;
+      }
+      if (entering < 0)
+        break;
+      int leaving = -1;
+      double least_ratio = 0;
+      for (int j = 0; j < n; ++j) {
+        double a = tableau[j * width + entering];
+        if (a <= PIVOT_TOLERANCE)
+          continue;
+        double ratio = tableau[j * width + width - 1] / a;
+        if (leaving < 0 || ratio < least_ratio
+            || (ratio == least_ratio && basis[j] < basis[leaving])) {
+          leaving = j;
+          least_ratio = ratio;
+        }
+      }
+      // The problem is bounded, since every entry of B is positive.
+      double* pivot_row = &tableau[leaving * width];
+      double pivot = pivot_row[entering];
+      for (int k = 0; k < width; ++k)
+        pivot_row[k] /= pivot;
+      for (int j = 0; j <= n; ++j) {
+        double* row = &tableau[j * width];
+        double factor = row[entering];
+        if (j == leaving || factor == 0)
+          continue;
+        for (int k = 0; k < width; ++k)
+          row[k] -= factor * pivot_row[k];
+      }
+      basis[leaving] = entering;
+    }
+
+    // The dual values of the constraints are minus the reduced costs of their
+    // slack variables. Normalized, they are an optimal strategy x for the
+    // column player.
+    double total = 0;
+    for (int j = 0; j < n; ++j) {
+      solution[j] = std::max(0.0, -objective[m + j]);
+      total += solution[j];
+    }
+    for (int j = 0; j < n; ++j)
+      solution[j] /= total;
+    // Decide on the least row under x itself, rather than on the computed
+    // value of the game.
+    double least_row = 0;
+    for (int i = 0; i < m; ++i) {
+      double row = 0;
+      for (int j = 0; j < n; ++j)
+        row += game[i * n + j] * solution[j];
+      least_row = (i == 0 ? row : min(least_row, row));
+    }
+    if (least_row <= VALUE_TOLERANCE) {
+      // The values of z are an optimal strategy for the row player, once
+      // normalized, under which no column does better than the value v <= 0.
+      for (int j = 0; j < n; ++j) {
+        if (basis[j] < m)
+          ray[enabled_rows[basis[j]]] = tableau[j * width + width - 1];
+      }
+      return false;
+    }
+    for (int j = 0; j < n; ++j)
+      solution[j] *= CONSTRAINT_EPSILON / least_row;
+    return true;
+  }
+
+  const double* GetSolution() const override {return solution.data();}
+  bool GetInfeasibilityRay(vector<double>* ray) const override {
+    *ray = this->ray;
+    return true;
+  }
+};
+
+}  // namespace Platt
+
+#endif /* DENSE_SIMPLEX_H_ */
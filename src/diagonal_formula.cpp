@@ -8,8 +8,10 @@
  */
 
 #include "diagonal_formula.h"
-#include <set>
 #include <algorithm>
+#include <map>
+#include <set>
+using std::map;
 using std::set;
 using std::sort;
 
@@ -17,65 +19,81 @@ namespace Platt {
 
   DiagonalFormula::DiagonalFormula(int d) :
       RestrictedTree(d-1, d-1, 2*d-2) {
-    // Build a set of all distinct subsequences of d-1 composites.
-    set <FactorizationSequence> FSs;
-    FactorizationSequence FS;
+    // Build a set of all distinct subsequences of d-1 composites. The
+    // traversals follow the composites by their ids, which are equal exactly
+    // when the factorizations are, so no Factorization is copied per node.
+    // Each subsequence is keyed by its FactorizationSequence, which orders
+    // them.
+    map<FactorizationSequence, vector<FactorizationId> > FSs;
+    set< vector<FactorizationId> > id_sequences;
+    vector<FactorizationId> ids;
 
     // Add composites to the sequence on the way down
-    auto PrechildFunctor = [&] (Node<Factorization>* N) {
-      if (!(N->GetData().IsPrime()))
-        FS.Push(N->GetData());
+    auto PrechildFunctor = [&] (Node<FactorizationId>* N) {
+      if (!(GetFactorization(N).IsPrime()))
+        ids.push_back(N->GetData());
     };
 
     // Remove composites on the way back up.
-    auto PostchildFunctor = [&] (Node<Factorization>* N) {
-      if (!(N->GetData().IsPrime()))
-        FS.Pop();
+    auto PostchildFunctor = [&] (Node<FactorizationId>* N) {
+      if (!(GetFactorization(N).IsPrime()))
+        ids.pop_back();
     };
 
     // Add the sequence to the set
-    auto LeafFunctor = [&] (Node<Factorization>* N) {
-      if (!(N->GetData().IsPrime()))
-              FS.Push(N->GetData());
-      FSs.insert(FS);
-      if (!(N->GetData().IsPrime()))
-              FS.Pop();
+    auto LeafFunctor = [&] (Node<FactorizationId>* N) {
+      bool composite = !(GetFactorization(N).IsPrime());
+      if (composite)
+        ids.push_back(N->GetData());
+      id_sequences.insert(ids);
+      if (composite)
+        ids.pop_back();
     };
 
     tree.DepthFirst(&PrechildFunctor, &PostchildFunctor, &LeafFunctor);
 
+    for (const vector<FactorizationId>& id_sequence : id_sequences) {
+      FactorizationSequence FS;
+      for (FactorizationId id : id_sequence)
+        FS.Push(table.GetFactorization(id));
+      FSs.emplace(FS, id_sequence);
+    }
+
     // Now pass over the tree for each FactorizationSequence and determine
     // its corresponding coefficient.
-    for(FactorizationSequence FS : FSs) {
-      vector<Node<Factorization>*> common;
-      vector<Node<Factorization>*> current;
-      FactorizationSequence currentFS;
+    for (const auto& entry : FSs) {
+      const FactorizationSequence& FS = entry.first;
+      const vector<FactorizationId>& FS_ids = entry.second;
+      vector<Node<FactorizationId>*> common;
+      vector<Node<FactorizationId>*> current;
+      vector<FactorizationId> current_ids;
 
       //
-      auto PrechildFunctor = [&] (Node<Factorization>* N) {
+      auto PrechildFunctor = [&] (Node<FactorizationId>* N) {
         current.push_back(N);
-        if (!(N->GetData()).IsPrime())
-          currentFS.Push(N->GetData());
+        if (!GetFactorization(N).IsPrime())
+          current_ids.push_back(N->GetData());
       };
 
 
-      auto PostchildFunctor = [&] (Node<Factorization>* N) {
+      auto PostchildFunctor = [&] (Node<FactorizationId>* N) {
         current.pop_back();
-        if (!(N->GetData()).IsPrime())
-                  currentFS.Pop();
+        if (!GetFactorization(N).IsPrime())
+          current_ids.pop_back();
       };
 
       // Add the sequence to the set
-      auto LeafFunctor = [&] (Node<Factorization>* N) {
+      auto LeafFunctor = [&] (Node<FactorizationId>* N) {
+        bool composite = !GetFactorization(N).IsPrime();
         current.push_back(N);
-        if (!(N->GetData()).IsPrime())
-                  currentFS.Push(N->GetData());
+        if (composite)
+          current_ids.push_back(N->GetData());
         // Case of first branch with the FS subsequence
         if(common.size() == 0) {
-          if (currentFS == FS)
+          if (current_ids == FS_ids)
             common = current;
         } else {  // common is populated
-          if (currentFS == FS) {
+          if (current_ids == FS_ids) {
             // Trim common down to the common lead sequence
             size_t x = common.size()-1;
             while(current[x] != common[x]) { // equality as pointers!
@@ -85,8 +103,8 @@ namespace Platt {
           }
         }
         current.pop_back();
-        if (!(N->GetData()).IsPrime())
-          currentFS.Pop();
+        if (composite)
+          current_ids.pop_back();
       };
 
       tree.DepthFirst(&PrechildFunctor, &PostchildFunctor, &LeafFunctor);
@@ -110,8 +128,8 @@ namespace Platt {
         n_offset.push_back(d-1-common.size());
       // Determine the number of composites in common.
       int num_comp = 0;
-      for (Node<Factorization>* N : common) {
-        if (!(N->GetData()).IsPrime())
+      for (Node<FactorizationId>* N : common) {
+        if (!GetFactorization(N).IsPrime())
           num_comp++;
       }
       // If there is just one branch for the FS, we choose all composites
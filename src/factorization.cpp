@@ -9,6 +9,7 @@
 
 #include "factorization.h"
 #include "compatibility.h"
+#include <cassert>
 #include <algorithm>
 using std::min;
 using std::max;
@@ -26,17 +27,25 @@ bool LexicographicallyLess(const Tuple& lhs, const Tuple& rhs) {
 // Constructors should set local_type_is_vector.
 Factorization::Factorization() {
   factors.push_back(Tuple(0,0));
+  UpdateInvariants();
 }
 
 Factorization::Factorization(unsigned int prime) {
-  factors.assign(1,Tuple(prime,1));
+  factors.push_back(Tuple(prime,1));
+  UpdateInvariants();
 }
 
-Factorization::Factorization(vector<Tuple> tuples) {
+Factorization::Factorization(const vector<Tuple>& tuples) {
   factors = tuples;
+  UpdateInvariants();
 }
 
-vector<Tuple> Factorization::SplitAndConvert(const string &s) {
+Factorization::Factorization(const TupleVector& tuples) {
+  factors = tuples;
+  UpdateInvariants();
+}
+
+TupleVector Factorization::SplitAndConvert(const string &s) {
   vector<string> first_split;
   stringstream ss1(s);
   string item;
@@ -44,7 +53,7 @@ vector<Tuple> Factorization::SplitAndConvert(const string &s) {
     first_split.push_back(item);
   }
 
-  vector<Tuple> second_split;
+  TupleVector second_split;
   for (size_t i = 0; i < first_split.size(); ++i) {
     stringstream ss2(first_split[i]);
     string item;
@@ -63,20 +72,60 @@ vector<Tuple> Factorization::SplitAndConvert(const string &s) {
 
 Factorization::Factorization(string serial_string) {
   factors = SplitAndConvert(serial_string);
+  UpdateInvariants();
 }
 
-Factorization::Factorization(const Factorization& f) {
+Factorization::Factorization(const Factorization& f)
+    : factors(f.factors), hash(f.hash), required_count(f.required_count),
+      num_prime_factors(f.num_prime_factors) {}
+
+Factorization::Factorization(Factorization&& f) noexcept
+    : factors(std::move(f.factors)), hash(f.hash),
+      required_count(f.required_count),
+      num_prime_factors(f.num_prime_factors) {}
+
+Factorization& Factorization::operator=(const Factorization& f) {
   factors = f.factors;
+  hash = f.hash;
+  required_count = f.required_count;
+  num_prime_factors = f.num_prime_factors;
+  return *this;
 }
 
-const Factorization& Factorization::operator=(const Factorization& f) {
-  factors = f.factors;
-  return f;
+Factorization& Factorization::operator=(Factorization&& f) noexcept {
+  factors = std::move(f.factors);
+  hash = f.hash;
+  required_count = f.required_count;
+  num_prime_factors = f.num_prime_factors;
+  return *this;
+}
+
+// Computes the hash, the required count and the number of prime factors in a
+// single pass over the factors. See RequiredCount() and Hash() for details.
+void Factorization::UpdateInvariants() {
+  hash = 0;
+  required_count = 1;
+  num_prime_factors = 0;
+  for (const Tuple& t : factors) {
+    // Each Tuple is mixed into the hash with the finalizer of the SplitMix64
+    // generator, so that factorizations differing in a single exponent get
+    // unrelated hashes.
+    hash ^= ((uint64_t) t.first << 32) | t.second;
+    hash += 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+
+    required_count *= t.second + 1;
+    num_prime_factors += t.second;
+  }
+  required_count--;
+  required_count /= 2;
 }
 
 // Implementation depends on the sorting of factors.
 Factorization Factorization::operator+(const Factorization& f) const{
-  vector<Tuple> sum;
+  TupleVector sum;
   size_t i = 0;
   size_t j = 0;
   // Go through both factorizations and add them to the sum, in order.
@@ -205,48 +254,33 @@ and if count is odd we want the value (count-1)/2.
   count = count / 2, rounded down
   return count
 */
+// The count is computed by UpdateInvariants().
 unsigned int Factorization::RequiredCount() const {
-  // Algorithm:
-  //   let count = 1
-  //   for each prime frequency pf:
-  //     count = count * (pf+1)
-  //   count = count - 1
-  //   count = count / 2, rounded down
-  //   return count
-
-  unsigned int count = 1;
-  for (Tuple t : factors) {
-    count *= t.second + 1;
-  }
-
-  count--;
-  count /= 2;
-  return count;
+  return required_count;
 }
 
-int Factorization::NumPrimeFactors() {
-  int count = 0;
-  for (Tuple t : factors) {
-    count += t.second;
-  }
-  return count;
+int Factorization::NumPrimeFactors() const {
+  return num_prime_factors;
 }
 
-int Factorization::NumDistinctPrimeFactors() {
+int Factorization::NumDistinctPrimeFactors() const {
   return factors.size();
 }
 
-vector<Tuple> Factorization::GetFactors() {
+const TupleVector& Factorization::GetFactors() const {
   return factors;
 }
 
 // Returns the index of the highest prime factor, using  0-based indexing.
-int Factorization::GetMaxPrime() {
-  int max_prime = 0;
-  for (Tuple t : factors) {
-    max_prime = max(max_prime, (int) t.first);
-  }
-  return max_prime;
+// Depends on the sorting of factors.
+int Factorization::GetMaxPrime() const {
+  assert(!factors.empty());
+  return factors.back().first;
+}
+
+// The hash is computed by UpdateInvariants().
+uint64_t Factorization::Hash() const {
+  return hash;
 }
 
 // Our lexicographical ordering is defined so that:
@@ -258,8 +292,8 @@ int Factorization::GetMaxPrime() {
 // This implementation depends on the sorting of factors.
 bool Factorization::LexicographicallyLess(const Factorization& lhs,
                                           const Factorization& rhs) {
-  vector<Tuple> lfactors = lhs.factors;
-  vector<Tuple> rfactors = rhs.factors;
+  const TupleVector& lfactors = lhs.factors;
+  const TupleVector& rfactors = rhs.factors;
   if(rhs.IsIdentity())
     return false;
   else if(lhs.IsIdentity())
@@ -292,7 +326,7 @@ bool Factorization::operator< (const Factorization& rhs) const {
 
 // Depends on sorting of factors
 bool Factorization::operator== (const Factorization& rhs) const {
-  if (factors.size() != rhs.factors.size())
+  if (hash != rhs.hash || factors.size() != rhs.factors.size())
     return false;
   for (size_t i = 0; i < factors.size(); ++i) {
     if (factors[i].first != rhs.factors[i].first
@@ -15,6 +15,10 @@
  *  but I have tried both implementations in the past and the Tuple method had
  *  slightly better performance in terms of time and space.
  *
+ *  The Tuples are kept in a TupleVector, which stores up to a few Tuples
+ *  inline, so that creating or copying a factorization does not normally
+ *  require a heap allocation.
+ *
  *  We present a table with examples corresponding to the natural numbers:
  *
  *  number  | ToDotString() | ToSerialString  |
@@ -25,18 +29,18 @@
 #ifndef FACTORIZATION_H_
 #define FACTORIZATION_H_
 
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <utility>
+#include "tuple_vector.h"
 using std::string;
 using std::vector;
 using std::pair;
 
 namespace Platt {
 
-// Note that "std::tuple" is a type!
-// A Tuple is a (prime, exponent) pair.
-typedef pair<unsigned int, unsigned int> Tuple;
 bool LexicographicallyLess(const Tuple& lhs, const Tuple& rhs);
 
 class Factorization {
@@ -44,19 +48,32 @@ class Factorization {
   // The tuples are ordered by lower primes to higher primes.
   // This fact is depended on by the implementations of operator+, operator==
   // and LexicographicallyLess.
-  vector<Tuple> factors;
+  TupleVector factors;
+
+  // Invariants that are derived from the factors. They are computed once, by
+  // UpdateInvariants(), whenever a factorization is constructed (including by
+  // operator+), instead of on every call of the accessors. The other accessors
+  // (IsPrime(), IsIdentity(), NumDistinctPrimeFactors(), GetMaxPrime()) only
+  // look at the size and the ends of the factors, so they need no cache.
+  uint64_t hash;
+  unsigned int required_count;
+  unsigned int num_prime_factors;
+  void UpdateInvariants();
 
   // Because C++ isn't Python
-  vector<Tuple> SplitAndConvert(const string &s);
+  TupleVector SplitAndConvert(const string &s);
 
  public:
   // The default constructor sets factorization to the identity.
   Factorization();
   Factorization(unsigned int);
-  Factorization(vector<Tuple>);
+  Factorization(const vector<Tuple>&);
+  Factorization(const TupleVector&);
   Factorization(string serial_string);
   Factorization(const Factorization&);
-  const Factorization& operator=(const Factorization&);
+  Factorization(Factorization&&) noexcept;
+  Factorization& operator=(const Factorization&);
+  Factorization& operator=(Factorization&&) noexcept;
   Factorization operator+(const Factorization&) const;
   // This program internally uses 0-based indexing and 1-based indexing for
   // primes and exponents, respectively. The Dot string is output with 1-based
@@ -67,11 +84,15 @@ class Factorization {
   bool IsPrimePower() const;
   bool IsIdentity() const;
   unsigned int RequiredCount() const;
-  int NumPrimeFactors();
-  int NumDistinctPrimeFactors();
-  vector<Tuple> GetFactors();
+  int NumPrimeFactors() const;
+  int NumDistinctPrimeFactors() const;
+  // The Tuples, without a copy. Iterate over them with a range-based for.
+  const TupleVector& GetFactors() const;
   // Returns the index of the highest prime factor, using  0-based indexing.
-  int GetMaxPrime();
+  // The factorization must not be a moved-from one, which has no factors.
+  int GetMaxPrime() const;
+  // A 64-bit hash of the factorization, for use in hash tables.
+  uint64_t Hash() const;
   // Used by the std::less function templated for Factorization, so that
   // Factorization can be used in std associative containters. See the .cpp
   // file for more details.
@@ -86,6 +107,10 @@ class Factorization {
   bool operator!= (const Factorization& rhs) const;
 };
 
+// std::vector only moves its elements when it grows if moving cannot throw.
+static_assert(std::is_nothrow_move_constructible<Factorization>::value,
+              "Factorization must be nothrow movable, or vectors of them copy.");
+
 }  // namespace Platt
 
 #endif  /* FACTORIZATION_H_ */
@@ -0,0 +1,127 @@
+/*
+ * factorization_id_map.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares and defines the FactorizationIdMap class, a small open addressing
+ *  hash table from FactorizationIds to unsigned integers. It is used by the
+ *  MultiplicationTable to group the frontier cells by their factorization.
+ *
+ *  The hash of a key is supplied by the caller (we use the 64-bit hash that
+ *  each Factorization computes once when it is built), so probing never has
+ *  to look at the factorization itself. Collisions are resolved by
+ *  linear probing, and Erase() shifts the following entries back so that no
+ *  tombstones are needed. Clear() keeps the allocated slots, so a map that is reused
+ *  across calls stops allocating once it has grown to its working size.
+ *
+ *  Implementation is inlined in the header since it is short.
+ */
+
+#ifndef FACTORIZATION_ID_MAP_H_
+#define FACTORIZATION_ID_MAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "factorization_pool.h"
+using std::fill;
+using std::vector;
+
+namespace Platt {
+
+class FactorizationIdMap {
+ private:
+  // Marks an unused slot. The pool never hands out this id.
+  enum : FactorizationId {EMPTY = 0xFFFFFFFF};
+
+  // The number of slots is always a power of two.
+  vector<FactorizationId> keys;
+  vector<uint64_t> hashes;
+  vector<unsigned int> values;
+  size_t count;
+
+  size_t Slot(FactorizationId key, uint64_t hash) const {
+    size_t mask = keys.size() - 1;
+    size_t slot = hash & mask;
+    while (keys[slot] != EMPTY && keys[slot] != key)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  void Rehash(size_t num_slots) {
+    vector<FactorizationId> old_keys(num_slots, EMPTY);
+    vector<uint64_t> old_hashes(num_slots);
+    vector<unsigned int> old_values(num_slots);
+    keys.swap(old_keys);
+    hashes.swap(old_hashes);
+    values.swap(old_values);
+    for (size_t i = 0; i < old_keys.size(); ++i) {
+      if (old_keys[i] != EMPTY) {
+        size_t slot = Slot(old_keys[i], old_hashes[i]);
+        keys[slot] = old_keys[i];
+        hashes[slot] = old_hashes[i];
+        values[slot] = old_values[i];
+      }
+    }
+  }
+
+ public:
+  FactorizationIdMap() : keys(16, EMPTY), hashes(16), values(16), count(0) {}
+
+  size_t Size() const {return count;}
+
+  void Clear() {
+    if (count > 0)
+      fill(keys.begin(), keys.end(), EMPTY);
+    count = 0;
+  }
+
+  // Returns the value stored for key. If key is not in the map, value is
+  // stored for it and returned.
+  unsigned int FindOrInsert(FactorizationId key, uint64_t hash,
+                            unsigned int value) {
+    // Keep the load factor at or below one half.
+    if (2 * (count + 1) > keys.size())
+      Rehash(2 * keys.size());
+    size_t slot = Slot(key, hash);
+    if (keys[slot] == EMPTY) {
+      keys[slot] = key;
+      hashes[slot] = hash;
+      values[slot] = value;
+      count++;
+    }
+    return values[slot];
+  }
+
+  // Returns a pointer to the value stored for key, or nullptr if key is not in
+  // the map. The pointer is valid until the map is next changed.
+  unsigned int* Find(FactorizationId key, uint64_t hash) {
+    size_t slot = Slot(key, hash);
+    return keys[slot] == EMPTY ? nullptr : &values[slot];
+  }
+
+  // Removes key, which must be in the map.
+  void Erase(FactorizationId key, uint64_t hash) {
+    size_t mask = keys.size() - 1;
+    size_t hole = Slot(key, hash);
+    // Move back every following entry of the run that could have been placed
+    // in the hole.
+    for (size_t slot = (hole + 1) & mask; keys[slot] != EMPTY;
+         slot = (slot + 1) & mask) {
+      size_t home = hashes[slot] & mask;
+      if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+        keys[hole] = keys[slot];
+        hashes[hole] = hashes[slot];
+        values[hole] = values[slot];
+        hole = slot;
+      }
+    }
+    keys[hole] = EMPTY;
+    count--;
+  }
+};
+
+}  // namespace Platt
+
+#endif /* FACTORIZATION_ID_MAP_H_ */
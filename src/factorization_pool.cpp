@@ -0,0 +1,59 @@
+/*
+ * factorization_pool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the FactorizationPool class.
+ */
+
+#include "factorization_pool.h"
+#include <algorithm>
+using std::min;
+using std::max;
+
+namespace Platt {
+
+FactorizationId FactorizationPool::Intern(const Factorization& f) {
+  uint64_t hash = f.Hash();
+  auto range = ids.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+    if (factorizations[it->second] == f)
+      return it->second;
+  FactorizationId id = factorizations.size();
+  factorizations.push_back(f);
+  ids.insert(pair<uint64_t, FactorizationId>(hash, id));
+  return id;
+}
+
+FactorizationId FactorizationPool::Sum(FactorizationId lhs,
+                                       FactorizationId rhs) {
+  uint64_t key = ((uint64_t) min(lhs, rhs) << 32) | max(lhs, rhs);
+  auto it = sums.find(key);
+  if (it != sums.end())
+    return it->second;
+  FactorizationId id = Intern(Get(lhs) + Get(rhs));
+  if (sums.size() >= MAX_SUMS)
+    sums.clear();
+  sums.insert(pair<uint64_t, FactorizationId>(key, id));
+  return id;
+}
+
+FactorizationId FactorizationPool::InternPacked(const PackedExponents& packed,
+                                                uint64_t hash) {
+  auto it = packed_ids.find(hash);
+  if (it != packed_ids.end()) {
+    // Every memoized entry was interned from a packed vector, so it packs.
+    PackedExponents memoized;
+    Pack(factorizations[it->second], &memoized);
+    if (PackedEqual(memoized, packed, PackedExponents::MAX_LANES))
+      return it->second;
+    // A collision: only the first vector with this hash is memoized.
+    return Intern(Unpack(packed));
+  }
+  FactorizationId id = Intern(Unpack(packed));
+  packed_ids.insert(pair<uint64_t, FactorizationId>(hash, id));
+  return id;
+}
+
+}  // namespace Platt
@@ -0,0 +1,70 @@
+/*
+ * factorization_pool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the FactorizationPool class. A pool interns factorizations: each
+ *  distinct factorization is stored once, and is referred to elsewhere by a
+ *  dense 32-bit FactorizationId. Two ids from the same pool are equal if and
+ *  only if their factorizations are equal, so comparing and hashing
+ *  factorizations becomes comparing and hashing integers.
+ *
+ *  A pool belongs to a single build (it is owned by the MultiplicationTable),
+ *  and ids from different pools must not be mixed.
+ */
+
+#ifndef FACTORIZATION_POOL_H_
+#define FACTORIZATION_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include "factorization.h"
+#include "packed_exponents.h"
+using std::deque;
+using std::unordered_map;
+using std::unordered_multimap;
+
+namespace Platt {
+
+typedef uint32_t FactorizationId;
+
+class FactorizationPool {
+ public:
+  // The most products that Sum() memoizes before it forgets them all.
+  static const size_t MAX_SUMS = 1 << 20;
+
+ private:
+  // A deque, so that references returned by Get() stay valid when the pool
+  // grows. This is the only copy of each factorization that the pool keeps.
+  deque<Factorization> factorizations;
+  // The ids of the factorizations, keyed by Hash(). Factorizations whose
+  // hashes collide are told apart by comparing them with the pool entries.
+  unordered_multimap<uint64_t, FactorizationId> ids;
+  // Memoizes Sum(), keyed by the pair of ids (smaller id in the high bits).
+  // Cleared when it reaches MAX_SUMS entries.
+  unordered_map<uint64_t, FactorizationId> sums;
+  // Memoizes InternPacked(), keyed by HashPacked(). Only the first vector
+  // with a given hash is memoized; a hit is checked against its pool entry.
+  unordered_map<uint64_t, FactorizationId> packed_ids;
+
+ public:
+  // Returns the id of f, adding f to the pool if it is not already present.
+  FactorizationId Intern(const Factorization& f);
+  // Returns the id of the product of the two factorizations.
+  FactorizationId Sum(FactorizationId lhs, FactorizationId rhs);
+  // Returns the id of the factorization packed, whose HashPacked() is hash.
+  FactorizationId InternPacked(const PackedExponents& packed, uint64_t hash);
+  const Factorization& Get(FactorizationId id) const {
+    return factorizations[id];
+  }
+  uint64_t GetHash(FactorizationId id) const {
+    return factorizations[id].Hash();
+  }
+  size_t Size() const {return factorizations.size();}
+};
+
+}  // namespace Platt
+
+#endif /* FACTORIZATION_POOL_H_ */
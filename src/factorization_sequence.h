@@ -24,13 +24,13 @@ class FactorizationSequence {
   vector<Factorization> factors;
 
  public:
-  void Push(Factorization f) {factors.push_back(f);}
+  void Push(const Factorization& f) {factors.push_back(f);}
   void Pop() {factors.pop_back();}
-  Factorization Back() {return factors.back();}
+  const Factorization& Back() const {return factors.back();}
 
-  string ToString() {
+  string ToString() const {
     string out = "[";
-    for(Factorization f: factors) {
+    for(const Factorization& f: factors) {
       out += f.ToDotString() + ",";
     }
     out[out.size()-1] = ']';
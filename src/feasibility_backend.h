@@ -0,0 +1,125 @@
+/*
+ * feasibility_backend.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the FeasibilityBackend interface, the solver behind the linear
+ *  programming checks (see linear_programming.h).
+ *
+ *  A backend holds a model whose columns are the weights of the primes, all
+ *  nonnegative, and whose rows are constraints sum_i a_i x_i >= epsilon. A row
+ *  can be disabled, which leaves it in the model but free. Solve() decides
+ *  whether the enabled rows can all be satisfied.
+ *
+ *  There are two backends:
+ *    - CLP, the Coin-Or linear programming library (see clp_backend.cpp), for
+ *      general problems.
+ *    - A dense simplex method (see dense_simplex.h) for problems with few
+ *      columns, which is most of them: the number of columns is the number of
+ *      primes of the current sequence.
+ *  NewFeasibilityBackend() picks one by the number of columns. When the code is
+ *  built with PLATT_WITHOUT_CLP defined, CLP is not used (or linked) at all and
+ *  the dense method handles every problem.
+ */
+
+#ifndef FEASIBILITY_BACKEND_H_
+#define FEASIBILITY_BACKEND_H_
+
+#include <exception>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace Platt {
+
+// The lower bound of every enabled row. Any positive value would do, since the
+// constraints are homogeneous.
+const double CONSTRAINT_EPSILON = 0.01;
+// Problems with at most this many columns are solved by the dense method.
+const int DENSE_MAX_COLUMNS = 6;
+
+// An exception class to handle an error if the linear programming backend fails
+// to either find a feasible solution, or prove that a feasible solution does
+// not exist.
+// Borrowed from https://riptutorial.com/cplusplus/example/23640/custom-exception
+class LinearProgrammingException: virtual public std::exception {
+protected:
+  std::string debug_str;
+  std::string error_message;
+public:
+  explicit
+  LinearProgrammingException(const string& msg, const string& debug_info):
+    debug_str(debug_info),
+    error_message(msg)
+    {}
+  ~LinearProgrammingException() throw () {}
+  /** Returns a pointer to the (constant) error description.
+   *  @return A pointer to a const char*. The underlying memory
+   *  is in possession of the Except object. Callers must
+   *  not attempt to free the memory.
+   */
+  virtual const char* what() const throw () {
+    return error_message.c_str();
+  }
+  const std::string& get_debug_info() const {
+    return debug_str;
+  }
+};
+
+class FeasibilityBackend {
+ public:
+  virtual ~FeasibilityBackend() {}
+
+  // Removes all the rows and columns.
+  virtual void Clear() = 0;
+  virtual int NumRows() const = 0;
+  virtual int NumColumns() const = 0;
+  // Adds a column, for the weight of a new prime.
+  virtual void AddColumn() = 0;
+  // Removes the last column. No row may use it.
+  virtual void RemoveLastColumn() = 0;
+  // Adds the row sum_i elements[i] * x[columns[i]] >= epsilon, with the n
+  // given coefficients.
+  virtual void AddRow(int n, const int* columns, const double* elements,
+                      bool enabled) = 0;
+  virtual void SetRowEnabled(int row, bool enabled) = 0;
+  // Removes the rows from first_row to the last one.
+  virtual void RemoveRowsFrom(int first_row) = 0;
+  // Returns whether the enabled rows can all be satisfied. Throws a
+  // LinearProgrammingException if the solver cannot decide; the model is left
+  // unchanged either way.
+  virtual bool Solve() = 0;
+  // After Solve() returns true, a solution: NumColumns() weights under which
+  // every enabled row is at least epsilon.
+  virtual const double* GetSolution() const = 0;
+  // After Solve() returns false, sets ray to a Farkas certificate of the
+  // infeasibility: NumRows() multipliers y >= 0, zero at the disabled rows, such
+  // that sum_r y_r * row_r has no positive coefficient. No nonnegative weights
+  // can make every row positive then. Returns false if the backend has none.
+  virtual bool GetInfeasibilityRay(vector<double>* ray) const = 0;
+};
+
+// Returns whether a problem with num_columns columns goes to the dense method.
+inline bool UseDenseBackend(int num_columns) {
+#ifdef PLATT_WITHOUT_CLP
+  (void) num_columns;
+  return true;
+#else
+  return num_columns <= DENSE_MAX_COLUMNS;
+#endif
+}
+
+// Returns a new backend suited to a problem with num_columns columns. The
+// caller owns it.
+FeasibilityBackend* NewFeasibilityBackend(int num_columns);
+
+#ifndef PLATT_WITHOUT_CLP
+// Returns a new backend that uses CLP. The caller owns it.
+FeasibilityBackend* NewClpBackend();
+#endif
+
+}  // namespace Platt
+
+#endif /* FEASIBILITY_BACKEND_H_ */
@@ -0,0 +1,274 @@
+/*
+ * feasible_cone.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the FeasibleCone class.
+ */
+
+#include "feasible_cone.h"
+#include <cstdlib>
+
+namespace Platt {
+
+namespace {
+
+int64_t Gcd(int64_t a, int64_t b) {
+  a = std::llabs(a);
+  b = std::llabs(b);
+  while (b != 0) {
+    int64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Returns whether every bit of subset is set in set.
+bool Contains(const vector<uint64_t>& set, const vector<uint64_t>& subset) {
+  for (size_t i = 0; i < subset.size(); ++i) {
+    if ((subset[i] & ~(i < set.size() ? set[i] : 0)) != 0)
+      return false;
+  }
+  return true;
+}
+
+void SetBit(vector<uint64_t>* bits, size_t index) {
+  if (bits->size() <= index / 64)
+    bits->resize(index / 64 + 1, 0);
+  (*bits)[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+// Clears the bits from index on.
+void ClearBitsFrom(vector<uint64_t>* bits, size_t index) {
+  if (bits->size() > (index + 63) / 64)
+    bits->resize((index + 63) / 64);
+  if (index % 64 != 0 && bits->size() > index / 64)
+    (*bits)[index / 64] &= (uint64_t(1) << (index % 64)) - 1;
+}
+
+}  // namespace
+
+// The empty sequence has no primes, so the cone is {0}.
+FeasibleCone::FeasibleCone() : dimension(0), inactive_pushes(0) {}
+
+FeasibleCone::Constraint FeasibleCone::MakeRow(const Factorization& f1,
+                                               const Factorization& f2) {
+  Constraint row;
+  for (unsigned int j = 0; j < MAX_DIMENSION; ++j)
+    row.coefficients[j] = 0;
+  for (const Tuple& t : f2.GetFactors())
+    row.coefficients[t.first] += t.second;
+  for (const Tuple& t : f1.GetFactors())
+    row.coefficients[t.first] -= t.second;
+  row.is_sequence_row = true;
+  return row;
+}
+
+int64_t FeasibleCone::Value(const Constraint& constraint, const Ray& ray) {
+  int64_t value = 0;
+  for (unsigned int j = 0; j < MAX_DIMENSION; ++j)
+    value += constraint.coefficients[j] * ray.coordinates[j];
+  return value;
+}
+
+// One step of the double description method. Each pair of a positive and a
+// negative ray that are adjacent (no other ray is tight at all the constraints
+// where both are) gives a new ray on the hyperplane between them.
+void FeasibleCone::AddNewRays(const vector<int64_t>& values, size_t index,
+                              const vector<Ray>& rays, vector<Ray>* new_rays) {
+  vector<uint64_t> common;
+  for (size_t p = 0; p < rays.size(); ++p) {
+    if (values[p] <= 0)
+      continue;
+    for (size_t n = 0; n < rays.size(); ++n) {
+      if (values[n] >= 0)
+        continue;
+      const vector<uint64_t>& zp = rays[p].zero_set;
+      const vector<uint64_t>& zn = rays[n].zero_set;
+      common.assign(std::min(zp.size(), zn.size()), 0);
+      for (size_t i = 0; i < common.size(); ++i)
+        common[i] = zp[i] & zn[i];
+      bool adjacent = true;
+      for (size_t r = 0; r < rays.size() && adjacent; ++r) {
+        if (r != p && r != n && Contains(rays[r].zero_set, common))
+          adjacent = false;
+      }
+      if (!adjacent)
+        continue;
+      Ray ray;
+      int64_t gcd = 0;
+      for (unsigned int j = 0; j < MAX_DIMENSION; ++j) {
+        ray.coordinates[j] = values[p] * rays[n].coordinates[j]
+                             - values[n] * rays[p].coordinates[j];
+        gcd = Gcd(gcd, ray.coordinates[j]);
+      }
+      for (unsigned int j = 0; j < MAX_DIMENSION; ++j)
+        ray.coordinates[j] /= gcd;
+      ray.zero_set = common;
+      SetBit(&ray.zero_set, index);
+      new_rays->push_back(ray);
+    }
+  }
+}
+
+// The rays on the nonnegative side are kept, and the new rays are added.
+void FeasibleCone::Cut(const Constraint& constraint, size_t index,
+                       const vector<Ray>& rays, vector<Ray>* cut_rays) {
+  cut_rays->clear();
+  vector<int64_t> values;
+  values.reserve(rays.size());
+  for (const Ray& ray : rays)
+    values.push_back(Value(constraint, ray));
+  for (size_t i = 0; i < rays.size(); ++i) {
+    if (values[i] >= 0) {
+      cut_rays->push_back(rays[i]);
+      if (values[i] == 0)
+        SetBit(&cut_rays->back().zero_set, index);
+    }
+  }
+  AddNewRays(values, index, rays, cut_rays);
+}
+
+// The cut is made in place, so only the rays it removes are kept for Pop().
+void FeasibleCone::Push(const Factorization& f, unsigned int num_primes) {
+  if (inactive_pushes > 0 || num_primes > MAX_DIMENSION) {
+    inactive_pushes++;
+    sequence.push_back(f);
+    return;
+  }
+  Level level;
+  level.dimension = dimension;
+  level.num_constraints = constraints.size();
+  level.num_rays = rays.size();
+  // A new prime adds the ray of its own weight, and the constraint that its
+  // weight is nonnegative, which is tight at every other ray.
+  while (dimension < num_primes) {
+    unsigned int column = dimension++;
+    Constraint nonnegative;
+    for (unsigned int j = 0; j < MAX_DIMENSION; ++j)
+      nonnegative.coefficients[j] = (j == column);
+    nonnegative.is_sequence_row = false;
+    size_t index = constraints.size();
+    constraints.push_back(nonnegative);
+    for (Ray& ray : rays)
+      SetBit(&ray.zero_set, index);
+    Ray ray;
+    for (unsigned int j = 0; j < MAX_DIMENSION; ++j)
+      ray.coordinates[j] = (j == column);
+    for (size_t i = 0; i < index; ++i) {
+      if (constraints[i].coefficients[column] == 0)
+        SetBit(&ray.zero_set, i);
+    }
+    rays.push_back(ray);
+  }
+  level.num_kept_rays = rays.size();
+  level.num_removed_rays = 0;
+  if (!sequence.empty()) {
+    constraints.push_back(MakeRow(sequence.back(), f));
+    size_t index = constraints.size() - 1;
+    values.clear();
+    for (const Ray& ray : rays)
+      values.push_back(Value(constraints.back(), ray));
+    next_rays.clear();
+    AddNewRays(values, index, rays, &next_rays);
+    size_t kept = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+      if (values[i] < 0) {
+        ray_log.push_back(pair<size_t, Ray>(i, std::move(rays[i])));
+        level.num_removed_rays++;
+        continue;
+      }
+      if (values[i] == 0)
+        SetBit(&rays[i].zero_set, index);
+      if (kept != i)
+        rays[kept] = std::move(rays[i]);
+      kept++;
+    }
+    rays.resize(kept);
+    level.num_kept_rays = kept;
+    for (Ray& ray : next_rays)
+      rays.push_back(std::move(ray));
+  }
+  levels.push_back(level);
+  sequence.push_back(f);
+}
+
+void FeasibleCone::Pop() {
+  sequence.pop_back();
+  if (inactive_pushes > 0) {
+    inactive_pushes--;
+    return;
+  }
+  const Level& level = levels.back();
+  rays.resize(level.num_kept_rays);
+  if (level.num_removed_rays > 0) {
+    // Merge the removed rays back in at their indices before the cut.
+    size_t r = ray_log.size() - level.num_removed_rays;
+    size_t log_begin = r;
+    size_t kept = 0;
+    next_rays.clear();
+    while (kept < rays.size() || r < ray_log.size()) {
+      if (r < ray_log.size() && ray_log[r].first == next_rays.size()) {
+        next_rays.push_back(std::move(ray_log[r++].second));
+      } else {
+        next_rays.push_back(std::move(rays[kept++]));
+      }
+    }
+    ray_log.resize(log_begin);
+    rays.swap(next_rays);
+  }
+  // Drop the rays of the new primes, and the constraints of the push.
+  rays.resize(level.num_rays);
+  for (Ray& ray : rays)
+    ClearBitsFrom(&ray.zero_set, level.num_constraints);
+  constraints.resize(level.num_constraints);
+  dimension = level.dimension;
+  levels.pop_back();
+}
+
+bool FeasibleCone::CanCheck(
+    const vector<const Factorization*>& candidates) const {
+  if (inactive_pushes > 0 || sequence.empty())
+    return false;
+  for (const Factorization* candidate : candidates) {
+    if ((unsigned int) candidate->GetMaxPrime() >= dimension)
+      return false;
+  }
+  return true;
+}
+
+bool FeasibleCone::IsFeasible(size_t k,
+                              const vector<const Factorization*>& candidates) {
+  check_constraints.clear();
+  check_constraints.push_back(MakeRow(sequence.back(), *candidates[k]));
+  for (size_t j = 0; j < candidates.size(); ++j) {
+    if (j != k)
+      check_constraints.push_back(MakeRow(*candidates[k], *candidates[j]));
+  }
+  check_rays = rays;
+  for (size_t i = 0; i < check_constraints.size(); ++i) {
+    Cut(check_constraints[i], constraints.size() + i, check_rays,
+        &next_rays);
+    check_rays.swap(next_rays);
+  }
+  // Every row must be positive on the sum of the rays.
+  Ray sum;
+  for (unsigned int j = 0; j < MAX_DIMENSION; ++j) {
+    sum.coordinates[j] = 0;
+    for (const Ray& ray : check_rays)
+      sum.coordinates[j] += ray.coordinates[j];
+  }
+  for (const Constraint& row : check_constraints) {
+    if (Value(row, sum) <= 0)
+      return false;
+  }
+  for (size_t i = 0; i < constraints.size(); ++i) {
+    if (constraints[i].is_sequence_row && Value(constraints[i], sum) <= 0)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace Platt
@@ -0,0 +1,111 @@
+/*
+ * feasible_cone.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the FeasibleCone class, an exact representation of the weights of
+ *  the primes that order the current sequence, for sequences with few primes.
+ *
+ *  The weights w >= 0 with (s_{i+1} - s_i) . w >= 0 for every pair of
+ *  consecutive numbers of the sequence form a polyhedral cone, which is kept
+ *  as the set of its extreme rays. Pushing a number cuts the cone by one
+ *  half-space (a step of the double description method), and popping undoes
+ *  the changes of the push. The rays have integer coordinates, reduced by
+ *  their gcd, so the representation is exact.
+ *
+ *  A system of strict inequalities on such a cone can be satisfied exactly
+ *  when each inequality is positive on some ray: the sum of the rays then
+ *  makes all of them positive at once. So a check cuts the cone by the rows
+ *  of the candidates and tests every row against the sum of the remaining
+ *  rays; no linear program is needed.
+ *
+ *  The number of rays can grow quickly with the dimension, so the cone is only
+ *  kept while the sequence has at most MAX_DIMENSION primes. Above that, the
+ *  LinearProgrammingContext falls back to its linear programs.
+ */
+
+#ifndef FEASIBLE_CONE_H_
+#define FEASIBLE_CONE_H_
+
+#include <cstdint>
+#include <vector>
+#include "factorization.h"
+using std::vector;
+
+namespace Platt {
+
+class FeasibleCone {
+ public:
+  static const unsigned int MAX_DIMENSION = 4;
+
+ private:
+  // A constraint row . w >= 0: either the nonnegativity of the weight of a
+  // prime, or the row of a pair of consecutive numbers of the sequence.
+  struct Constraint {
+    int64_t coefficients[MAX_DIMENSION];
+    bool is_sequence_row;
+  };
+  struct Ray {
+    int64_t coordinates[MAX_DIMENSION];
+    // Bit i is set if constraint i is tight (zero) at the ray.
+    vector<uint64_t> zero_set;
+  };
+  // The state before each push, so that a pop can undo it: the rays of the
+  // new primes are appended, the cut moves the rays it removes to ray_log
+  // (with their index before the cut) and appends the rays it makes.
+  struct Level {
+    unsigned int dimension;
+    size_t num_constraints;
+    size_t num_rays;
+    // The rays left by the cut, before its new rays.
+    size_t num_kept_rays;
+    size_t num_removed_rays;
+  };
+
+  vector<Constraint> constraints;
+  vector<Ray> rays;
+  unsigned int dimension;
+  vector<Level> levels;
+  vector< pair<size_t, Ray> > ray_log;
+  // The numbers of the sequence, for the rows of the candidates.
+  vector<Factorization> sequence;
+  // The number of pushes made while the sequence had too many primes, for
+  // which no level was made.
+  unsigned int inactive_pushes;
+  // Scratch space for a check.
+  vector<Ray> check_rays;
+  vector<Ray> next_rays;
+  vector<int64_t> values;
+  vector<Constraint> check_constraints;
+
+  // Returns constraint row f2 - f1 (which must fit in the dimension).
+  static Constraint MakeRow(const Factorization& f1, const Factorization& f2);
+  static int64_t Value(const Constraint& constraint, const Ray& ray);
+  // Appends to new_rays the rays that cutting the cone given by rays by the
+  // constraint of index index makes on its hyperplane. values holds the value
+  // of the constraint at each ray.
+  static void AddNewRays(const vector<int64_t>& values, size_t index,
+                         const vector<Ray>& rays, vector<Ray>* new_rays);
+  // Cuts the cone given by rays by constraint, whose index is index.
+  static void Cut(const Constraint& constraint, size_t index,
+                  const vector<Ray>& rays, vector<Ray>* cut_rays);
+
+ public:
+  FeasibleCone();
+
+  // Appends f to the sequence. num_primes is the number of primes of the
+  // sequence including f.
+  void Push(const Factorization& f, unsigned int num_primes);
+  void Pop();
+  // Whether the cone is kept for the current sequence, and covers all the
+  // primes of the candidates.
+  bool CanCheck(const vector<const Factorization*>& candidates) const;
+  // Returns whether candidates[k] can come right after the sequence and before
+  // all the other candidates. CanCheck(candidates) must be true.
+  bool IsFeasible(size_t k, const vector<const Factorization*>& candidates);
+};
+
+}  // namespace Platt
+
+#endif /* FEASIBLE_CONE_H_ */
@@ -29,13 +29,12 @@ IntegerTree::IntegerTree(string filename) {
 
 void IntegerTree::NextLevel() {}
 
-void IntegerTree::RecursiveBuild(unsigned int height, Node<Factorization>* n) {
+void IntegerTree::RecursiveBuild(unsigned int height, Node<FactorizationId>* n) {
   if (height > 0) {
     // Add composites and recurse
     vector<Candidate> candidates = table.GetCandidates();
-    for(Candidate c : candidates) {
-      Node<Factorization>* child = new Node<Factorization>(c.GetFactors());
-      n->Add(child);
+    for(const Candidate& c : candidates) {
+      Node<FactorizationId>* child = tree.AddChild(n, c.GetFactorizationId());
       if (height > 1) {
         table.PushComposite(c);
         RecursiveBuild(height - 1, child);
@@ -43,10 +42,10 @@ void IntegerTree::RecursiveBuild(unsigned int height, Node<Factorization>* n) {
       }
     }
 
-    // Add prime and recurse
-    Node<Factorization>* child = new Node<Factorization>(
-                                         Factorization(table.GetPrimeCount()));
-    n->Add(child);
+    // Add prime among the composites, which come in lexicographic order, and
+    // recurse
+    Node<FactorizationId>* child = AddChildInOrder(
+        n, table.Intern(Factorization(table.GetPrimeCount())));
     if (height > 1) {
       table.PushPrime();
       RecursiveBuild(height - 1, child);
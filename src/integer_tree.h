@@ -22,7 +22,7 @@ namespace Platt {
 
 class IntegerTree : public BeurlingTreeBase {
  private:
-  void RecursiveBuild(unsigned int height, Node<Factorization>* n);
+  void RecursiveBuild(unsigned int height, Node<FactorizationId>* n);
 
  public:
   // Default Constructor initializes with just a root node.
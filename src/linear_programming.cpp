@@ -8,38 +8,41 @@
  *  factorizations after the multiplication table's binary product check has
  *  been done.
  *
- *  This implementation uses the Coin-Or CLP library.
+ *  The linear programs are solved by a FeasibilityBackend; see
+ *  feasibility_backend.h.
  */
 
 #include <algorithm>  // For std::max
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
-#include "ClpSimplex.hpp"
-#include "CoinHelperFunctions.hpp"
 #include "factorization.h"
 #include "linear_programming.h"
 using std::cout;
 using std::endl;
 using std::max;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 
 namespace Platt {
 
 // Returns pairs of <prime index, coefficient value> for the 
 // constraint row defined by f1 < f2,  ie. f2 - f1 > 0.
-vector<pair<int, double>> GetConstraintCoefficients(Factorization f1,
-                                                    Factorization f2) {
+vector<pair<int, double>> GetConstraintCoefficients(const Factorization& f1,
+                                                    const Factorization& f2) {
   int max_prime = max(f1.GetMaxPrime(), f2.GetMaxPrime());
   vector<double> coefficients;
   for (int i = 0; i <= max_prime; i++) {
     coefficients.push_back(0.0);
   }
-  for (Tuple t : f2.GetFactors()) {
+  for (const Tuple& t : f2.GetFactors()) {
     coefficients[t.first] = t.second;
   }
-  for (Tuple t : f1.GetFactors()) {
+  for (const Tuple& t : f1.GetFactors()) {
     coefficients[t.first] -= t.second;
   }
   vector<pair<int, double>> sparse_coefficients;
@@ -77,134 +80,884 @@ void PrintMatrixDebugString(int num_constraints, int num_primes,
 
 bool IsFeasibleSequence(
   const vector<Factorization>& current_sequence,
-  Factorization candidate,
+  const Factorization& candidate,
   const vector<Factorization>& other_candidates) {
-  // Determine: num_primes (col) and num_constraints (row).
-  // The vector current_sequence includes the identity factorization.
-  int num_constraints = current_sequence.size() - 1
-                        + 1
-                        + other_candidates.size();
-  int num_primes = 0;
-  for (Factorization f : current_sequence) {
+  // Determine num_primes, the number of columns. The vector current_sequence
+  // includes the identity factorization.
+  int num_primes = candidate.GetMaxPrime();
+  for (const Factorization& f : current_sequence) {
+    num_primes = max(num_primes, f.GetMaxPrime());
+  }
+  for (const Factorization& f : other_candidates) {
     num_primes = max(num_primes, f.GetMaxPrime());
   }
   num_primes++;
-  // Setup LP solver.
-  // Variable declarations.
-  ClpSimplex  model;
-  model.setLogLevel(0);  // Supress console output.
-  // The constraint matrix is defined using a sparse notation.
-  // Arrays for row index i and column index j.
-  vector<int> rowIndices;
-  vector<int> colIndices;
-  // Array for values "r" at indices i,j. (A_{i,j} = r).
-  vector<double> elements;
-  // Set the values of the constraint matrix.
-  // This is the lefthand side of the inequality Ax ?= b. (In our case Ax > 0)
+  unique_ptr<FeasibilityBackend> backend(NewFeasibilityBackend(num_primes));
+  for (int j = 0; j < num_primes; j++) {
+    backend->AddColumn();
+  }
+  // We add the constraint rows, the lefthand side of the inequality Ax > 0
+  // (the backend uses Ax >= epsilon), for
+  //   - the current sequence
+  //   - the candidate factorization
+  //   - the other candidates
   // Anything not explicitly set is assumed to be 0.
-  // We add constraints
-  //   - for current sequence
-  //   - for candidate factorization
-  //   - for other candidates
-  // Add constraints for the current sequence.
-  int num_nonzero_elements = 0;
-  int row_index = 0;
-  while(row_index < current_sequence.size() - 1) {
-    vector<pair<int, double>> constraint_coefficients = 
-        GetConstraintCoefficients(current_sequence[row_index],
-                                  current_sequence[row_index + 1]);
-    for (auto p : constraint_coefficients) {
-      rowIndices.push_back(row_index);
-      colIndices.push_back(p.first);
-      elements.push_back(p.second);
-      num_nonzero_elements++;
-    }
-    row_index++;
-  }
-  // Add constraints for the candidate factorization.
-  vector<pair<int, double>> constraint_coefficients = 
-      GetConstraintCoefficients(current_sequence.back(), candidate);
-  for (auto p : constraint_coefficients) {
-    rowIndices.push_back(row_index);
-    colIndices.push_back(p.first);
-    elements.push_back(p.second);
-    num_nonzero_elements++;
-  }
-  row_index++;
-  // Add constraints for the other candidate factorizations.
-  for(Factorization other_candidate : other_candidates) {
-    vector<pair<int, double>> constraint_coefficients = 
-        GetConstraintCoefficients(candidate, other_candidate);
-    for (auto p : constraint_coefficients) {
-      rowIndices.push_back(row_index);
-      colIndices.push_back(p.first);
+  vector<int> columns;
+  vector<double> elements;
+  auto add_constraint = [&] (const Factorization& f1, const Factorization& f2) {
+    columns.clear();
+    elements.clear();
+    for (auto p : GetConstraintCoefficients(f1, f2)) {
+      columns.push_back(p.first);
       elements.push_back(p.second);
-      num_nonzero_elements++;
-    }
-    row_index++;
-  }
-  // Make sure the row_index and num_constraints variables are consistent.
-  if (row_index != num_constraints) {
-    cout << "Improper row_index" << endl;
-    cout << "num_constraints == " << num_constraints << endl;
-    cout << "row_index == " << row_index << endl;
-  }
-  // Load the matrix.
-  // The "true" means that the matrix data are stored in column order.
-  CoinPackedMatrix matrix(true, rowIndices.data(), colIndices.data(),
-                          elements.data(), num_nonzero_elements);
-  // Print Debugging for small examples.
-  // PrintMatrixDebugString(num_constraints, num_primes, num_nonzero_elements,
-  //                        rowIndices, colIndices, elements);
-  // Create problem.
-  // Set the coefficients of optimization.
-  // These values are required for running the program, but
-  // otherwise irrelevant to us since we only care about
-  // feasibility of the constraints and not any particular values
-  // of a solution.
-  vector<double> objective;
-  for (int j = 0; j < num_primes; j++) {
-    objective.push_back(1);
+    }
+    backend->AddRow(columns.size(), columns.data(), elements.data(), true);
+  };
+  for (size_t i = 0; i + 1 < current_sequence.size(); i++) {
+    add_constraint(current_sequence[i], current_sequence[i + 1]);
   }
-  // Set the "row bounds". This is the righthand side of the
-  // inequality Ax ?= b. Ultimately, we wish to solve the
-  // inequality Ax > 0, so we use small "epsilon" lower bound values for b.
-  double epsilon = 0.01;
-  vector<double> rowLower;
-  for (int i = 0; i < num_constraints; i++) {
-    rowLower.push_back(epsilon);
-  }
-  // Load the problem.
-  // According to https://www.coin-or.org/Doxygen/Clp/classClpSimplex.html,
-  // NULL pointers means default to largest possible row/column upper/lower
-  // bounds.
-  model.loadProblem(matrix, 0, 0, objective.data(), rowLower.data(), 0);
-  // Run the solver so can check if the problem is infeasible.
-  model.initialSolve();
-  // Return true or false.
-  if (model.isProvenOptimal()) {
-    // Housekeeping: nothing to do.
+  add_constraint(current_sequence.back(), candidate);
+  for (const Factorization& other_candidate : other_candidates) {
+    add_constraint(candidate, other_candidate);
+  }
+  return backend->Solve();
+}
+
+FeasibilityBackend* NewFeasibilityBackend(int num_columns) {
+#ifndef PLATT_WITHOUT_CLP
+  if (!UseDenseBackend(num_columns))
+    return NewClpBackend();
+#else
+  (void) num_columns;
+#endif
+  return new DenseSimplexBackend();
+}
+
+bool IsProperDivisor(const Factorization& f1, const Factorization& f2) {
+  // A proper divisor has fewer prime factors, counted with multiplicity. This
+  // also rules out f1 == f2, and f2 being the identity.
+  if (f1.NumPrimeFactors() >= f2.NumPrimeFactors())
+    return false;
+  const Tuple* it2 = f2.GetFactors().begin();
+  const Tuple* end2 = f2.GetFactors().end();
+  for (const Tuple& t : f1.GetFactors()) {
+    if (t.second == 0)
+      continue;  // The identity.
+    while (it2 != end2 && it2->first < t.first)
+      ++it2;
+    if (it2 == end2 || it2->first != t.first || it2->second < t.second)
+      return false;
+  }
+  return true;
+}
+
+// The least value of a row for a witness to satisfy it. Any positive value
+// proves the strict inequality; the margin keeps the rounding errors of the
+// solver from deciding a check.
+const double WITNESS_MARGIN = CONSTRAINT_EPSILON / 2;
+// The largest multiplier of a certificate is scaled to this, and the others
+// rounded to integers with it. It is the lcm of 1, ..., 16, so multipliers in
+// ratios with small denominators are recovered exactly.
+const int64_t CERTIFICATE_SCALE = 720720;
+
+namespace {
+
+// The value of f under the prime weights of witness, a sparse dot product.
+double WitnessValue(const Factorization& f, const vector<double>& witness) {
+  double value = 0;
+  for (const Tuple& t : f.GetFactors()) {
+    if (t.second != 0)
+      value += t.second * (t.first < witness.size() ? witness[t.first] : 0.0);
+  }
+  return value;
+}
+
+// The finalizer of the splitmix64 generator, which mixes all the bits of x.
+uint64_t Mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// The fingerprint of one sparse row. The fingerprint of a system is the sum of
+// those of its rows, so it does not depend on their order.
+ConstraintFingerprint RowFingerprint(int n, const int* columns,
+                                     const double* elements) {
+  ConstraintFingerprint fingerprint;
+  fingerprint.low = 0x9e3779b97f4a7c15ULL;
+  fingerprint.high = 0x6a09e667f3bcc909ULL;
+  for (int i = 0; i < n; ++i) {
+    uint64_t entry = ((uint64_t) (uint32_t) columns[i] << 32)
+                     ^ (uint64_t) (int64_t) elements[i];
+    fingerprint.low = Mix(fingerprint.low ^ entry);
+    fingerprint.high = Mix(fingerprint.high + Mix(entry));
+  }
+  return fingerprint;
+}
+
+}  // namespace
+
+LinearProgrammingContext::LinearProgrammingContext(
+    size_t verdict_cache_capacity)
+    : large_backend(nullptr), backend(&dense_backend), sequence_row_starts(1, 0),
+      verdicts(verdict_cache_capacity), recorder_session(0),
+      recorder_context(0), recording(false) {
+  if (LinearProgrammingRecorder* recorder =
+          LinearProgrammingRecorder::Active()) {
+    recorder_session = recorder->Session();
+    recorder_context = recorder->RegisterContext();
+  }
+}
+
+LinearProgrammingRecorder* LinearProgrammingContext::Recorder() const {
+  LinearProgrammingRecorder* recorder = LinearProgrammingRecorder::Active();
+  if (recorder == nullptr || recorder->Session() != recorder_session)
+    return nullptr;
+  return recorder;
+}
+
+uint64_t LinearProgrammingContext::NanosecondsSince(
+    std::chrono::steady_clock::time_point begin) const {
+  if (!recording)
+    return 0;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - begin).count();
+}
+
+LinearProgrammingContext::~LinearProgrammingContext() {
+  delete large_backend;
+}
+
+// Backends are only switched when the number of primes crosses
+// DENSE_MAX_COLUMNS, so replaying the rows of the sequence is rare.
+void LinearProgrammingContext::SelectBackend(unsigned int num_primes) {
+  FeasibilityBackend* selected = &dense_backend;
+  if (!UseDenseBackend(num_primes)) {
+    if (large_backend == nullptr)
+      large_backend = NewFeasibilityBackend(num_primes);
+    selected = large_backend;
+  }
+  if (selected == backend)
+    return;
+  backend->Clear();
+  backend = selected;
+  while ((unsigned int) backend->NumColumns() < num_primes)
+    backend->AddColumn();
+  for (size_t row = 0; row < sequence_row_in_model.size(); ++row) {
+    if (sequence_row_in_model[row])
+      AddSequenceRow(row);
+  }
+}
+
+// The coefficients are merged from the sorted Tuples of the factorizations, so
+// no dense vector is needed.
+void LinearProgrammingContext::MakeConstraintRow(const Factorization& f1,
+                                                 const Factorization& f2,
+                                                 vector<int>* columns,
+                                                 vector<double>* elements) {
+  columns->clear();
+  elements->clear();
+  const Tuple* it1 = f1.GetFactors().begin();
+  const Tuple* end1 = f1.GetFactors().end();
+  const Tuple* it2 = f2.GetFactors().begin();
+  const Tuple* end2 = f2.GetFactors().end();
+  while (it1 != end1 || it2 != end2) {
+    int column;
+    double element;
+    if (it2 == end2 || (it1 != end1 && it1->first < it2->first)) {
+      column = it1->first;
+      element = -(double) it1->second;
+      ++it1;
+    } else if (it1 == end1 || it2->first < it1->first) {
+      column = it2->first;
+      element = it2->second;
+      ++it2;
+    } else {
+      column = it1->first;
+      element = (double) it2->second - (double) it1->second;
+      ++it1;
+      ++it2;
+    }
+    if (element != 0) {
+      columns->push_back(column);
+      elements->push_back(element);
+    }
+  }
+}
+
+void LinearProgrammingContext::AddConstraintRow(const Factorization& f1,
+                                                const Factorization& f2,
+                                                bool enabled) {
+  MakeConstraintRow(f1, f2);
+  backend->AddRow(row_columns.size(), row_columns.data(), row_elements.data(),
+                  enabled);
+}
+
+// A row implies another when each of its coefficients is at most the
+// corresponding one of the other.
+bool LinearProgrammingContext::IsImpliedRow() const {
+  for (size_t row = 0; row < sequence_row_in_model.size(); ++row) {
+    if (!sequence_row_in_model[row])
+      continue;
+    int k = sequence_row_starts[row];
+    int end = sequence_row_starts[row + 1];
+    size_t i = 0;
+    bool implied = true;
+    while (implied && (k < end || i < row_columns.size())) {
+      if (i == row_columns.size()
+          || (k < end && sequence_row_columns[k] < row_columns[i])) {
+        implied = sequence_row_elements[k] <= 0;
+        ++k;
+      } else if (k == end || row_columns[i] < sequence_row_columns[k]) {
+        implied = row_elements[i] >= 0;
+        ++i;
+      } else {
+        implied = sequence_row_elements[k] <= row_elements[i];
+        ++k;
+        ++i;
+      }
+    }
+    if (implied)
+      return true;
+  }
+  return false;
+}
+
+void LinearProgrammingContext::AddSequenceRow(size_t row) {
+  int begin = sequence_row_starts[row];
+  backend->AddRow(sequence_row_starts[row + 1] - begin,
+                  &sequence_row_columns[begin], &sequence_row_elements[begin],
+                  true);
+}
+
+void LinearProgrammingContext::Push(const Factorization& f,
+                                    unsigned int num_primes) {
+  if (LinearProgrammingRecorder* recorder = Recorder())
+    recorder->RecordPush(recorder_context, f, num_primes);
+  cone.Push(f, num_primes);
+  SelectBackend(num_primes);
+  while ((unsigned int) backend->NumColumns() < num_primes)
+    backend->AddColumn();
+  if (!sequence.empty()) {
+    MakeConstraintRow(sequence.back(), f);
+    bool in_model = !IsImpliedRow();
+    sequence_row_columns.insert(sequence_row_columns.end(),
+                                row_columns.begin(), row_columns.end());
+    sequence_row_elements.insert(sequence_row_elements.end(),
+                                 row_elements.begin(), row_elements.end());
+    sequence_row_starts.push_back(sequence_row_columns.size());
+    sequence_row_in_model.push_back(in_model);
+    sequence_row_fingerprints.push_back(RowFingerprint(
+        row_columns.size(), row_columns.data(), row_elements.data()));
+    if (in_model) {
+      AddSequenceRow(sequence_row_in_model.size() - 1);
+    } else {
+      stats.redundant_rows++;
+    }
+    // Drop the witnesses that do not satisfy the new row. The others still
+    // satisfy every row of the sequence, also after it is popped.
+    for (size_t i = 0; i < witnesses.size();) {
+      if (WitnessValue(f, witnesses[i])
+          - WitnessValue(sequence.back(), witnesses[i]) < WITNESS_MARGIN) {
+        witnesses.erase(witnesses.begin() + i);
+      } else {
+        ++i;
+      }
+    }
+  }
+  sequence.push_back(f);
+}
+
+void LinearProgrammingContext::Pop(unsigned int num_primes) {
+  if (LinearProgrammingRecorder* recorder = Recorder())
+    recorder->RecordPop(recorder_context, num_primes);
+  cone.Pop();
+  sequence.pop_back();
+  while (!certificates.empty() && certificates.back().depth > sequence.size())
+    certificates.pop_back();
+  if (!sequence.empty()) {
+    if (sequence_row_in_model.back()) {
+      backend->RemoveRowsFrom(backend->NumRows() - 1);
+      for (unique_ptr<Worker>& worker : workers) {
+        worker->synced_rows = std::min(worker->synced_rows,
+                                       backend->NumRows());
+      }
+    }
+    sequence_row_in_model.pop_back();
+    sequence_row_fingerprints.pop_back();
+    sequence_row_starts.pop_back();
+    sequence_row_columns.resize(sequence_row_starts.back());
+    sequence_row_elements.resize(sequence_row_starts.back());
+  }
+  while ((unsigned int) backend->NumColumns() > num_primes)
+    backend->RemoveLastColumn();
+  SelectBackend(num_primes);
+}
+
+bool LinearProgrammingContext::Solve(int first_candidate_row) {
+  try {
+    return backend->Solve();
+  } catch (const LinearProgrammingException&) {
+    backend->RemoveRowsFrom(first_candidate_row);
+    throw;
+  }
+}
+
+// The multipliers come from a floating point solve, so the certificate is
+// checked exactly before it is kept: the multipliers are rounded to integers
+// (see CERTIFICATE_SCALE), and the sum of the integer rows under them must have
+// no positive coefficient. Then no weights can make the rows with a positive
+// multiplier all positive. A ray that fails this is ignored.
+void LinearProgrammingContext::AddCertificate(
+    size_t k, const vector<const Factorization*>& candidates,
+    const vector<double>& ray, int first_row) {
+  double largest = 0;
+  for (double y : ray)
+    largest = max(largest, y);
+  if (largest <= 0)
+    return;
+  auto multiplier = [&] (int row) -> int64_t {
+    return ray[row] > 0 ? std::llround(ray[row] / largest * CERTIFICATE_SCALE)
+                        : 0;
+  };
+  int last_row = first_row + candidates.size();
+  vector<int64_t> sum(backend->NumColumns(), 0);
+  auto add_row = [&] (int n, const int* columns, const double* elements,
+                      int64_t m) {
+    for (int i = 0; i < n; ++i)
+      sum[columns[i]] += m * std::llround(elements[i]);
+  };
+  int model_row = 0;
+  for (size_t row = 0; row < sequence_row_in_model.size(); ++row) {
+    if (!sequence_row_in_model[row])
+      continue;
+    int64_t m = multiplier(model_row++);
+    if (m > 0) {
+      int begin = sequence_row_starts[row];
+      add_row(sequence_row_starts[row + 1] - begin,
+              &sequence_row_columns[begin], &sequence_row_elements[begin], m);
+    }
+  }
+  for (int row = model_row; row < (int) ray.size(); ++row) {
+    if (multiplier(row) > 0 && (row < first_row || row >= last_row))
+      return;  // A disabled row.
+  }
+  Certificate certificate;
+  certificate.candidate = *candidates[k];
+  certificate.depth = sequence.size();
+  MakeConstraintRow(sequence.back(), *candidates[k]);
+  if (multiplier(first_row) > 0) {
+    add_row(row_columns.size(), row_columns.data(), row_elements.data(),
+            multiplier(first_row));
+  }
+  int row = first_row + 1;
+  for (size_t j = 0; j < candidates.size(); ++j) {
+    if (j == k)
+      continue;
+    if (multiplier(row) > 0) {
+      MakeConstraintRow(*candidates[k], *candidates[j]);
+      add_row(row_columns.size(), row_columns.data(), row_elements.data(),
+              multiplier(row));
+      certificate.others.push_back(*candidates[j]);
+    }
+    ++row;
+  }
+  for (int64_t coefficient : sum) {
+    if (coefficient > 0)
+      return;
+  }
+  if (certificates.size() == MAX_CERTIFICATES)
+    return;
+  certificates.push_back(certificate);
+  stats.certificates++;
+}
+
+bool LinearProgrammingContext::IsCertified(
+    size_t k, const vector<const Factorization*>& candidates) const {
+  for (const Certificate& certificate : certificates) {
+    if (certificate.candidate != *candidates[k])
+      continue;
+    bool applies = true;
+    for (const Factorization& other : certificate.others) {
+      bool found = false;
+      for (size_t j = 0; j < candidates.size() && !found; ++j)
+        found = j != k && *candidates[j] == other;
+      applies = applies && found;
+    }
+    if (applies)
+      return true;
+  }
+  return false;
+}
+
+// The rows of the check are made next to each other first, since pointers
+// into them are only stable once they are all made.
+ConstraintFingerprint LinearProgrammingContext::Fingerprint(
+    size_t k, const vector<const Factorization*>& candidates) {
+  check_row_starts.assign(1, 0);
+  check_row_columns.clear();
+  check_row_elements.clear();
+  check_row_fingerprints.clear();
+  auto add_row = [&] (const Factorization& f1, const Factorization& f2) {
+    MakeConstraintRow(f1, f2);
+    check_row_columns.insert(check_row_columns.end(), row_columns.begin(),
+                             row_columns.end());
+    check_row_elements.insert(check_row_elements.end(), row_elements.begin(),
+                              row_elements.end());
+    check_row_starts.push_back(check_row_columns.size());
+    check_row_fingerprints.push_back(RowFingerprint(
+        row_columns.size(), row_columns.data(), row_elements.data()));
+  };
+  add_row(sequence.back(), *candidates[k]);
+  for (size_t j = 0; j < candidates.size(); ++j) {
+    if (j != k)
+      add_row(*candidates[k], *candidates[j]);
+  }
+
+  reduced_rows.clear();
+  for (size_t row = 0; row < sequence_row_in_model.size(); ++row) {
+    if (sequence_row_in_model[row]) {
+      int begin = sequence_row_starts[row];
+      reduced_rows.push_back({&sequence_row_columns[begin],
+                              &sequence_row_elements[begin],
+                              sequence_row_starts[row + 1] - begin,
+                              &sequence_row_fingerprints[row]});
+    }
+  }
+  for (size_t row = 0; row < check_row_fingerprints.size(); ++row) {
+    int begin = check_row_starts[row];
+    reduced_rows.push_back({&check_row_columns[begin],
+                            &check_row_elements[begin],
+                            check_row_starts[row + 1] - begin,
+                            &check_row_fingerprints[row]});
+  }
+  negative_counts.clear();
+  for (const ReducedRow& row : reduced_rows) {
+    for (int i = 0; i < row.size; ++i) {
+      if ((size_t) row.columns[i] >= negative_counts.size())
+        negative_counts.resize(row.columns[i] + 1, 0);
+      if (row.elements[i] < 0)
+        negative_counts[row.columns[i]]++;
+    }
+  }
+  // Drop the rows with a column that has no negative coefficient left, until
+  // there are none.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t r = 0; r < reduced_rows.size();) {
+      const ReducedRow& row = reduced_rows[r];
+      bool free_column = false;
+      for (int i = 0; i < row.size && !free_column; ++i)
+        free_column = negative_counts[row.columns[i]] == 0;
+      if (!free_column) {
+        ++r;
+        continue;
+      }
+      for (int i = 0; i < row.size; ++i) {
+        if (row.elements[i] < 0)
+          negative_counts[row.columns[i]]--;
+      }
+      reduced_rows[r] = reduced_rows.back();
+      reduced_rows.pop_back();
+      changed = true;
+    }
+  }
+  ConstraintFingerprint fingerprint;
+  for (const ReducedRow& row : reduced_rows) {
+    fingerprint.low += row.fingerprint->low;
+    fingerprint.high += row.fingerprint->high;
+  }
+  return fingerprint;
+}
+
+void LinearProgrammingContext::AddWitness(const double* solution) {
+  if (witnesses.size() < MAX_WITNESSES)
+    witnesses.push_back(vector<double>());
+  // Reuse the storage of the oldest witness for the new one.
+  std::rotate(witnesses.begin(), witnesses.end() - 1, witnesses.end());
+  witnesses.front().assign(solution, solution + backend->NumColumns());
+}
+
+// Under a witness, only the candidate of least value can come first, so each
+// witness proves at most one candidate.
+void LinearProgrammingContext::CheckWitnesses(
+    const vector<const Factorization*>& candidates, vector<bool>* proven) {
+  proven->assign(candidates.size(), false);
+  for (const vector<double>& witness : witnesses) {
+    double last_value = WitnessValue(sequence.back(), witness);
+    candidate_values.clear();
+    size_t least = 0;
+    for (size_t k = 0; k < candidates.size(); ++k) {
+      candidate_values.push_back(WitnessValue(*candidates[k], witness));
+      if (candidate_values[k] < candidate_values[least])
+        least = k;
+    }
+    if (candidate_values[least] - last_value < WITNESS_MARGIN)
+      continue;
+    bool satisfied = true;
+    for (size_t k = 0; k < candidates.size(); ++k) {
+      if (k != least
+          && candidate_values[k] - candidate_values[least] < WITNESS_MARGIN)
+        satisfied = false;
+    }
+    if (satisfied)
+      (*proven)[least] = true;
+  }
+}
+
+// A proper divisor of a number of the sequence would have to come before it,
+// so it is never a candidate, and the sequence need not be searched.
+bool LinearProgrammingContext::IsDominated(
+    const Factorization& candidate,
+    const vector<const Factorization*>& candidates) const {
+  for (const Factorization* other_candidate : candidates) {
+    if (IsProperDivisor(*other_candidate, candidate))
+      return true;
+  }
+  return false;
+}
+
+bool LinearProgrammingContext::IsFeasible(
+    const Factorization& candidate,
+    const vector<const Factorization*>& other_candidates) {
+  vector<const Factorization*> candidates(1, &candidate);
+  candidates.insert(candidates.end(), other_candidates.begin(),
+                    other_candidates.end());
+  LinearProgrammingRecorder* recorder = Recorder();
+  recording = recorder != nullptr;
+  outcomes.assign(1, CheckOutcome());
+  outcomes[0].feasible = Check(candidates);
+  if (recording)
+    recorder->RecordCheck(recorder_context, candidates, outcomes);
+  return outcomes[0].feasible;
+}
+
+bool LinearProgrammingContext::Check(
+    const vector<const Factorization*>& candidates) {
+  CheckOutcome& outcome = outcomes[0];
+  std::chrono::steady_clock::time_point begin;
+  if (recording)
+    begin = std::chrono::steady_clock::now();
+  if (IsDominated(*candidates[0], candidates)) {
+    stats.dominated_candidates++;
+    outcome.method = DOMINANCE_METHOD;
+    return false;
+  }
+  if (cone.CanCheck(candidates)) {
+    stats.cone_checks++;
+    outcome.method = CONE_METHOD;
+    bool feasible = cone.IsFeasible(0, candidates);
+    outcome.nanoseconds = NanosecondsSince(begin);
+    return feasible;
+  }
+  vector<bool> proven;
+  CheckWitnesses(candidates, &proven);
+  if (proven[0]) {
+    stats.witness_hits++;
+    outcome.method = WITNESS_METHOD;
     return true;
-  } else if (model.isProvenPrimalInfeasible()) {
-    // Housekeeping: nothing to do.
+  }
+  if (IsCertified(0, candidates)) {
+    stats.certificate_hits++;
+    outcome.method = CERTIFICATE_METHOD;
     return false;
-  } else {
-    string error_string = string("Linear Programming Exception: CLP has failed"
-        " to either find a feasible solution or prove that a feasible solution"
-        " does not exist.");
-    string debug_string = "";
-    if (model.isPrimalObjectiveLimitReached()) {
-      debug_string += "Primal Objective Limit Reached\n";
+  }
+  stats.witness_misses++;
+  bool use_verdicts = verdicts.GetCapacity() > 0;
+  ConstraintFingerprint fingerprint;
+  bool feasible;
+  if (use_verdicts) {
+    fingerprint = Fingerprint(0, candidates);
+    if (verdicts.Find(fingerprint, &feasible)) {
+      stats.verdict_hits++;
+      outcome.method = VERDICT_CACHE_METHOD;
+      return feasible;
     }
-    if (model.isIterationLimitReached()) {
-      debug_string += "Iteration Limit Reached\n";
+    stats.verdict_misses++;
+  }
+  // The candidate rows are added after the rows of the sequence, and removed
+  // again before returning.
+  int first_candidate_row = backend->NumRows();
+  AddConstraintRow(sequence.back(), *candidates[0], true);
+  for (size_t j = 1; j < candidates.size(); ++j)
+    AddConstraintRow(*candidates[0], *candidates[j], true);
+  if (recording)
+    begin = std::chrono::steady_clock::now();
+  feasible = Solve(first_candidate_row);
+  stats.solves++;
+  outcome.method = SOLVE_METHOD;
+  outcome.nanoseconds = NanosecondsSince(begin);
+  if (feasible) {
+    AddWitness(backend->GetSolution());
+  } else if (backend->GetInfeasibilityRay(&ray)) {
+    AddCertificate(0, candidates, ray, first_candidate_row);
+  }
+  backend->RemoveRowsFrom(first_candidate_row);
+  if (use_verdicts)
+    verdicts.Insert(fingerprint, feasible);
+  return feasible;
+}
+
+// A candidate that is dominated is infeasible, and the others are decided by
+// the cone while it can check them. Otherwise a candidate that a witness proves
+// is feasible, and one that is certified infeasible is not. The others are
+// looked up in the VerdictCache, and those not found are checked with the
+// model. The rows of those checks are added at once, disabled, in one
+// block per candidate: the row for the candidate after the last number of the
+// sequence, then its rows before each of the other candidates. Each check
+// enables its block, solves, and disables it again.
+void LinearProgrammingContext::IsFeasibleBatch(
+    const vector<const Factorization*>& candidates, vector<bool>* feasible) {
+  LinearProgrammingRecorder* recorder = Recorder();
+  recording = recorder != nullptr;
+  outcomes.assign(candidates.size(), CheckOutcome());
+  CheckBatch(candidates, feasible);
+  if (recording) {
+    for (size_t k = 0; k < candidates.size(); ++k)
+      outcomes[k].feasible = (*feasible)[k];
+    recorder->RecordCheck(recorder_context, candidates, outcomes);
+  }
+}
+
+void LinearProgrammingContext::CheckBatch(
+    const vector<const Factorization*>& candidates, vector<bool>* feasible) {
+  size_t n = candidates.size();
+  std::chrono::steady_clock::time_point begin;
+  dominated.assign(n, false);
+  for (size_t k = 0; k < n; ++k) {
+    if (IsDominated(*candidates[k], candidates)) {
+      dominated[k] = true;
+      stats.dominated_candidates++;
+      outcomes[k].method = DOMINANCE_METHOD;
     }
-    if (model.isAbandoned()) {
-      debug_string += "Problem \"Abandoned\" by CLP\n";
+  }
+  if (cone.CanCheck(candidates)) {
+    feasible->assign(n, false);
+    for (size_t k = 0; k < n; ++k) {
+      if (!dominated[k]) {
+        stats.cone_checks++;
+        if (recording)
+          begin = std::chrono::steady_clock::now();
+        (*feasible)[k] = cone.IsFeasible(k, candidates);
+        outcomes[k].method = CONE_METHOD;
+        outcomes[k].nanoseconds = NanosecondsSince(begin);
+      }
+    }
+    return;
+  }
+  bool use_verdicts = verdicts.GetCapacity() > 0;
+  CheckWitnesses(candidates, feasible);
+  undecided_candidates.clear();
+  undecided_fingerprints.clear();
+  for (size_t k = 0; k < n; ++k) {
+    if (dominated[k]) {
+      // No witness can prove a dominated candidate.
+      continue;
+    } else if ((*feasible)[k]) {
+      stats.witness_hits++;
+      outcomes[k].method = WITNESS_METHOD;
+    } else if (IsCertified(k, candidates)) {
+      stats.certificate_hits++;
+      outcomes[k].method = CERTIFICATE_METHOD;
+    } else {
+      stats.witness_misses++;
+      if (use_verdicts) {
+        ConstraintFingerprint fingerprint = Fingerprint(k, candidates);
+        bool verdict;
+        if (verdicts.Find(fingerprint, &verdict)) {
+          stats.verdict_hits++;
+          (*feasible)[k] = verdict;
+          outcomes[k].method = VERDICT_CACHE_METHOD;
+          continue;
+        }
+        stats.verdict_misses++;
+        undecided_fingerprints.push_back(fingerprint);
+      }
+      undecided_candidates.push_back(k);
     }
-    throw(LinearProgrammingException(error_string, debug_string));
   }
+  if (undecided_candidates.empty())
+    return;
+  if (pool != nullptr && undecided_candidates.size() > 1) {
+    SolveInParallel(candidates, feasible);
+    return;
+  }
+
+  int first_candidate_row = backend->NumRows();
+  for (size_t k : undecided_candidates) {
+    AddConstraintRow(sequence.back(), *candidates[k], false);
+    for (size_t j = 0; j < n; ++j) {
+      if (j != k)
+        AddConstraintRow(*candidates[k], *candidates[j], false);
+    }
+  }
+  for (size_t b = 0; b < undecided_candidates.size(); ++b) {
+    int first_row = first_candidate_row + b * n;
+    for (size_t i = 0; i < n; ++i)
+      backend->SetRowEnabled(first_row + i, true);
+    if (recording)
+      begin = std::chrono::steady_clock::now();
+    bool verdict = Solve(first_candidate_row);
+    stats.solves++;
+    outcomes[undecided_candidates[b]].method = SOLVE_METHOD;
+    outcomes[undecided_candidates[b]].nanoseconds = NanosecondsSince(begin);
+    if (verdict) {
+      (*feasible)[undecided_candidates[b]] = true;
+      AddWitness(backend->GetSolution());
+    } else if (backend->GetInfeasibilityRay(&ray)) {
+      AddCertificate(undecided_candidates[b], candidates, ray, first_row);
+    }
+    if (use_verdicts)
+      verdicts.Insert(undecided_fingerprints[b], verdict);
+    for (size_t i = 0; i < n; ++i)
+      backend->SetRowEnabled(first_row + i, false);
+  }
+  backend->RemoveRowsFrom(first_candidate_row);
 }
 
-}  // namespace Platt
+void LinearProgrammingContext::SetNumThreads(unsigned int num_threads) {
+  pool.reset();
+  workers.clear();
+  if (num_threads <= 1)
+    return;
+  for (unsigned int t = 0; t < num_threads; ++t)
+    workers.push_back(unique_ptr<Worker>(new Worker()));
+  pool.reset(new ThreadPool(num_threads));
+}
 
+// Called on the thread of the worker, while the context is not changed.
+void LinearProgrammingContext::SyncWorker(Worker* worker) {
+  int num_columns = backend->NumColumns();
+  FeasibilityBackend* selected = &worker->dense_backend;
+  if (!UseDenseBackend(num_columns)) {
+    if (worker->large_backend == nullptr)
+      worker->large_backend.reset(NewFeasibilityBackend(num_columns));
+    selected = worker->large_backend.get();
+  }
+  if (selected != worker->backend) {
+    worker->backend->Clear();
+    worker->backend = selected;
+    worker->synced_rows = 0;
+  }
+  worker->backend->RemoveRowsFrom(worker->synced_rows);
+  while (worker->backend->NumColumns() > num_columns)
+    worker->backend->RemoveLastColumn();
+  while (worker->backend->NumColumns() < num_columns)
+    worker->backend->AddColumn();
+  int model_row = 0;
+  for (size_t row = 0; row < sequence_row_in_model.size(); ++row) {
+    if (!sequence_row_in_model[row])
+      continue;
+    if (model_row++ < worker->synced_rows)
+      continue;
+    int begin = sequence_row_starts[row];
+    worker->backend->AddRow(sequence_row_starts[row + 1] - begin,
+                            &sequence_row_columns[begin],
+                            &sequence_row_elements[begin], true);
+  }
+  worker->synced_rows = model_row;
+}
+
+// Any exception is kept in the result, to be passed on by SolveInParallel().
+void LinearProgrammingContext::RunWorker(
+    unsigned int t, const vector<const Factorization*>& candidates) {
+  if (t >= undecided_candidates.size())
+    return;
+  Worker* worker = workers[t].get();
+  try {
+    SyncWorker(worker);
+  } catch (...) {
+    worker->synced_rows = 0;
+    for (size_t b = t; b < undecided_candidates.size(); b += workers.size())
+      check_results[b].error = std::current_exception();
+    return;
+  }
+  FeasibilityBackend* worker_backend = worker->backend;
+  int first_row = worker_backend->NumRows();
+  for (size_t b = t; b < undecided_candidates.size(); b += workers.size()) {
+    CheckResult& result = check_results[b];
+    size_t k = undecided_candidates[b];
+    result.error = nullptr;
+    result.first_row = first_row;
+    try {
+      auto add_row = [&] (const Factorization& f1, const Factorization& f2) {
+        MakeConstraintRow(f1, f2, &worker->row_columns, &worker->row_elements);
+        worker_backend->AddRow(worker->row_columns.size(),
+                               worker->row_columns.data(),
+                               worker->row_elements.data(), true);
+      };
+      add_row(sequence.back(), *candidates[k]);
+      for (size_t j = 0; j < candidates.size(); ++j) {
+        if (j != k)
+          add_row(*candidates[k], *candidates[j]);
+      }
+      std::chrono::steady_clock::time_point begin =
+          std::chrono::steady_clock::now();
+      result.feasible = worker_backend->Solve();
+      result.nanoseconds = std::chrono::duration_cast<
+          std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin)
+          .count();
+      if (result.feasible) {
+        const double* solution = worker_backend->GetSolution();
+        result.solution.assign(solution,
+                               solution + worker_backend->NumColumns());
+      } else {
+        result.has_ray = worker_backend->GetInfeasibilityRay(&result.ray);
+      }
+    } catch (...) {
+      result.error = std::current_exception();
+    }
+    worker_backend->RemoveRowsFrom(first_row);
+  }
+}
+
+// The results are merged in the order of the candidates, as the loop of
+// IsFeasibleBatch() would have made them, so a failed solve is passed on after
+// the results of the candidates before it are merged.
+void LinearProgrammingContext::SolveInParallel(
+    const vector<const Factorization*>& candidates, vector<bool>* feasible) {
+  check_results.resize(undecided_candidates.size());
+  pool->Run([&] (unsigned int t) {RunWorker(t, candidates);});
+  bool use_verdicts = verdicts.GetCapacity() > 0;
+  for (size_t b = 0; b < undecided_candidates.size(); ++b) {
+    const CheckResult& result = check_results[b];
+    if (result.error != nullptr)
+      std::rethrow_exception(result.error);
+    size_t k = undecided_candidates[b];
+    stats.solves++;
+    outcomes[k].method = SOLVE_METHOD;
+    outcomes[k].nanoseconds = result.nanoseconds;
+    if (result.feasible) {
+      (*feasible)[k] = true;
+      AddWitness(result.solution.data());
+    } else if (result.has_ray) {
+      AddCertificate(k, candidates, result.ray, result.first_row);
+    }
+    if (use_verdicts)
+      verdicts.Insert(undecided_fingerprints[b], result.feasible);
+  }
+}
+
+vector<bool> AreFeasibleCandidates(
+    const vector<Factorization>& current_sequence,
+    const vector<Factorization>& candidates) {
+  // Unlike IsFeasibleSequence(), the columns must also cover the primes of
+  // the candidates, since all their rows are in the model at once.
+  int num_primes = 0;
+  for (const Factorization& f : current_sequence)
+    num_primes = max(num_primes, f.GetMaxPrime() + 1);
+  vector<const Factorization*> candidate_pointers;
+  for (const Factorization& f : candidates) {
+    num_primes = max(num_primes, f.GetMaxPrime() + 1);
+    candidate_pointers.push_back(&f);
+  }
+  LinearProgrammingContext context;
+  for (const Factorization& f : current_sequence)
+    context.Push(f, num_primes);
+  vector<bool> feasible;
+  context.IsFeasibleBatch(candidate_pointers, &feasible);
+  return feasible;
+}
+
+}  // namespace Platt
@@ -14,58 +14,303 @@
 #define LINEAR_PROGRAMMING_H_
 
 #include <algorithm>  // For std::max
+#include <chrono>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
+#include "dense_simplex.h"
 #include "factorization.h"
+#include "feasibility_backend.h"
+#include "feasible_cone.h"
+#include "linear_programming_recorder.h"
+#include "thread_pool.h"
+#include "verdict_cache.h"
 using std::cout;
 using std::endl;
 using std::max;
 using std::string;
+using std::unique_ptr;
 using std::vector;
 
 namespace Platt {
 
-// An exception class to handle an error if the linear programming backend fails
-// to either find a feasible solution, or prove that a feasible solution does
-// not exist.
-// Borrowed from https://riptutorial.com/cplusplus/example/23640/custom-exception
-class LinearProgrammingException: virtual public std::exception {
-protected:
-  std::string debug_str;
-  std::string error_message;
-public:
-  explicit
-  LinearProgrammingException(const string& msg, const string& debug_info):
-    error_message(msg),
-    debug_str(debug_info)
-    {}
-  ~LinearProgrammingException() throw () {}
-  /** Returns a pointer to the (constant) error description.
-   *  @return A pointer to a const char*. The underlying memory
-   *  is in possession of the Except object. Callers must
-   *  not attempt to free the memory.
-   */
-  virtual const char* what() const throw () {
-    return error_message.c_str();
+// Counts of the work done by a LinearProgrammingContext, for profiling.
+struct LinearProgrammingStats {
+  // The checks shown to be feasible by a cached witness, without a solve.
+  unsigned long witness_hits;
+  // The checks that no cached witness satisfied, which needed a solve or a
+  // cached verdict.
+  unsigned long witness_misses;
+  // The checks decided without the model because the candidate is a multiple
+  // of another candidate.
+  unsigned long dominated_candidates;
+  // The rows of the sequence left out of the model because an earlier row
+  // implies them.
+  unsigned long redundant_rows;
+  // The checks decided by the FeasibleCone, while the sequence has few primes.
+  unsigned long cone_checks;
+  // The checks whose reduced system was found in the VerdictCache, and those
+  // that were not and were solved.
+  unsigned long verdict_hits;
+  unsigned long verdict_misses;
+  // The infeasibility certificates kept, and the checks they decided.
+  unsigned long certificates;
+  unsigned long certificate_hits;
+  // The checks decided by solving the model.
+  unsigned long solves;
+
+  LinearProgrammingStats()
+      : witness_hits(0), witness_misses(0), dominated_candidates(0),
+        redundant_rows(0), cone_checks(0), verdict_hits(0), verdict_misses(0),
+        certificates(0), certificate_hits(0), solves(0) {}
+};
+
+// A linear program that is kept between calls, for the checks made by a
+// MultiplicationTable. The rows of the current sequence are kept in one model
+// that follows the sequence with Push() and Pop(), so a check only adds the
+// rows of its candidates and solves again from the basis of the previous
+// solve. Most checks are decided by cheaper tests before the model is solved.
+class LinearProgrammingContext {
+ private:
+  // The columns of the model are the primes of the sequence. The dense
+  // method is used for up to DENSE_MAX_COLUMNS primes, and the backend for
+  // larger problems (CLP unless PLATT_WITHOUT_CLP is defined) past that. Only
+  // the one in use, pointed to by backend, holds the rows of the sequence.
+  DenseSimplexBackend dense_backend;
+  FeasibilityBackend* large_backend;
+  FeasibilityBackend* backend;
+  // Decides the checks exactly, without the model, while the sequence has at
+  // most FeasibleCone::MAX_DIMENSION primes.
+  FeasibleCone cone;
+  // The numbers of the sequence, so that the row for a new number can be made
+  // from the last one.
+  vector<Factorization> sequence;
+  // The coefficients of the row of each number of the sequence but the first,
+  // stored as in DenseSimplexBackend, and whether that row is in the model. A
+  // row implied by an earlier one in the model is left out (see IsImpliedRow()).
+  vector<int> sequence_row_starts;
+  vector<int> sequence_row_columns;
+  vector<double> sequence_row_elements;
+  vector<bool> sequence_row_in_model;
+  vector<ConstraintFingerprint> sequence_row_fingerprints;
+  // Scratch space for the sparse coefficients of one row.
+  vector<int> row_columns;
+  vector<double> row_elements;
+  vector<bool> dominated;
+  vector<size_t> undecided_candidates;
+  vector<ConstraintFingerprint> undecided_fingerprints;
+  vector<double> candidate_values;
+  // Scratch space for Fingerprint(): the rows of a check, stored as the rows
+  // of the sequence, the rows of the reduced system, and the number of
+  // negative coefficients of each column in them.
+  vector<int> check_row_starts;
+  vector<int> check_row_columns;
+  vector<double> check_row_elements;
+  vector<ConstraintFingerprint> check_row_fingerprints;
+  struct ReducedRow {
+    const int* columns;
+    const double* elements;
+    int size;
+    const ConstraintFingerprint* fingerprint;
+  };
+  vector<ReducedRow> reduced_rows;
+  vector<int> negative_counts;
+
+  // A candidate that cannot come before all the others while the sequence
+  // starts with its first depth numbers. It is made from the Farkas ray of an
+  // infeasible solve, and decides the same check further down the branch as
+  // long as the others are still candidates.
+  struct Certificate {
+    Factorization candidate;
+    vector<Factorization> others;
+    size_t depth;
+  };
+  static const size_t MAX_CERTIFICATES = 64;
+  // In the order they were made, so the deepest ones come last.
+  vector<Certificate> certificates;
+  vector<double> ray;
+
+  // The prime weights of the last few feasible solves. Push() drops those that
+  // break the new row, so a witness proves a check if it satisfies the rows of
+  // the candidates. The most recent witness comes first.
+  static const size_t MAX_WITNESSES = 8;
+  vector<vector<double>> witnesses;
+  // The verdicts of solved checks, keyed by the fingerprint of the reduced
+  // system of the check (see Fingerprint()).
+  VerdictCache verdicts;
+  LinearProgrammingStats stats;
+
+  // A thread's own copy of the model, for the solves of IsFeasibleBatch().
+  // Thread t of T solves the undecided candidates t, t + T, ..., and the
+  // results are merged in the order of the candidates.
+  struct Worker {
+    DenseSimplexBackend dense_backend;
+    unique_ptr<FeasibilityBackend> large_backend;
+    FeasibilityBackend* backend;
+    // The rows of the backend from the first, which are the rows of the
+    // sequence that are in the model. Only the first synced_rows of them are
+    // known to be the same as in the model of the context.
+    int synced_rows;
+    vector<int> row_columns;
+    vector<double> row_elements;
+
+    Worker() : backend(&dense_backend), synced_rows(0) {}
+  };
+  // The outcome of the solve of one undecided candidate on a Worker.
+  struct CheckResult {
+    bool feasible;
+    vector<double> solution;
+    bool has_ray;
+    vector<double> ray;
+    int first_row;
+    uint64_t nanoseconds;
+    std::exception_ptr error;
+  };
+  unique_ptr<ThreadPool> pool;
+  vector<unique_ptr<Worker>> workers;
+  vector<CheckResult> check_results;
+
+  // The session of the LinearProgrammingRecorder that existed when the context
+  // was made, if any, and the id it gave the context. Pushes, pops and checks
+  // are logged to it while it exists.
+  unsigned long recorder_session;
+  unsigned int recorder_context;
+  // Whether the current check is recorded, and the outcomes of its
+  // candidates.
+  bool recording;
+  vector<CheckOutcome> outcomes;
+
+  // Switches to the backend for num_primes columns, moving the rows of the
+  // sequence to it.
+  void SelectBackend(unsigned int num_primes);
+  // Sets columns and elements to the row f1 < f2, ie. f2 - f1 > 0.
+  static void MakeConstraintRow(const Factorization& f1,
+                                const Factorization& f2, vector<int>* columns,
+                                vector<double>* elements);
+  // The same, into row_columns and row_elements.
+  void MakeConstraintRow(const Factorization& f1, const Factorization& f2) {
+    MakeConstraintRow(f1, f2, &row_columns, &row_elements);
   }
-  const std::string& get_debug_info() const {
-    return debug_str;
+  // Adds the row f1 < f2 to the model, enabled or not.
+  void AddConstraintRow(const Factorization& f1, const Factorization& f2,
+                        bool enabled);
+  // Returns whether a row of the sequence that is in the model implies the row
+  // in row_columns and row_elements.
+  bool IsImpliedRow() const;
+  // Adds the row of the sequence number row, which is in the model, to it.
+  void AddSequenceRow(size_t row);
+  // Solves the model and returns whether it is feasible. If the solver fails,
+  // the candidate rows, from first_candidate_row on, are removed and the
+  // LinearProgrammingException is passed on.
+  bool Solve(int first_candidate_row);
+  // Returns the fingerprint of the reduced system of the check of
+  // candidates[k] against the other candidates. Rows with a column that has
+  // no negative coefficient are dropped until none is left; the reduced system
+  // is feasible exactly when the full one is.
+  ConstraintFingerprint Fingerprint(
+      size_t k, const vector<const Factorization*>& candidates);
+  // Keeps the certificate given by ray, of a solve that found the check of
+  // candidates[k], with its rows from first_row on, infeasible.
+  void AddCertificate(size_t k, const vector<const Factorization*>& candidates,
+                      const vector<double>& ray, int first_row);
+  // Returns whether a certificate shows that candidates[k] cannot come before
+  // all the other candidates.
+  bool IsCertified(size_t k,
+                   const vector<const Factorization*>& candidates) const;
+  // Returns the recorder of the context, if it still exists.
+  LinearProgrammingRecorder* Recorder() const;
+  // Returns the nanoseconds since begin when recording, and 0 otherwise.
+  uint64_t NanosecondsSince(std::chrono::steady_clock::time_point begin) const;
+  // IsFeasible() for candidates[0] before the other candidates, and
+  // IsFeasibleBatch(), without the recording. They set the methods and times
+  // of outcomes. A check is decided by the first of: dominance, the cone, a
+  // witness, a certificate, the VerdictCache, and a solve of the model.
+  bool Check(const vector<const Factorization*>& candidates);
+  void CheckBatch(const vector<const Factorization*>& candidates,
+                  vector<bool>* feasible);
+  // Keeps solution, of a solve, as a witness.
+  void AddWitness(const double* solution);
+  // Brings the rows and columns of the backend of worker up to date with the
+  // model.
+  void SyncWorker(Worker* worker);
+  // Solves the checks of the undecided candidates of the share of thread t,
+  // into check_results.
+  void RunWorker(unsigned int t,
+                 const vector<const Factorization*>& candidates);
+  // Solves the checks of the undecided candidates on the ThreadPool, and
+  // merges the results as IsFeasibleBatch() would have made them.
+  void SolveInParallel(const vector<const Factorization*>& candidates,
+                       vector<bool>* feasible);
+  // Sets (*proven)[k] to whether a witness shows that candidates[k] can come
+  // before all the other candidates.
+  void CheckWitnesses(const vector<const Factorization*>& candidates,
+                      vector<bool>* proven);
+  // Returns whether candidate can be rejected without the model: it is a
+  // proper multiple of one of the candidates, so it must come after that
+  // candidate.
+  bool IsDominated(const Factorization& candidate,
+                   const vector<const Factorization*>& candidates) const;
+
+ public:
+  // The IntegerTree and PrimePowerTree builds never repeat a reduced system, so
+  // the VerdictCache is off unless a search that revisits sequences asks.
+  static const size_t DEFAULT_VERDICT_CACHE_CAPACITY = 0;
+
+  explicit LinearProgrammingContext(
+      size_t verdict_cache_capacity = DEFAULT_VERDICT_CACHE_CAPACITY);
+  ~LinearProgrammingContext();
+  // The model is not copied.
+  LinearProgrammingContext(const LinearProgrammingContext&) = delete;
+  LinearProgrammingContext& operator=(const LinearProgrammingContext&) = delete;
+
+  // Appends f to the sequence. num_primes is the number of primes of the
+  // sequence including f.
+  void Push(const Factorization& f, unsigned int num_primes);
+  // Removes the last number of the sequence. num_primes is the number of
+  // primes of the sequence without it.
+  void Pop(unsigned int num_primes);
+  // The same as IsFeasibleSequence() for the current sequence.
+  bool IsFeasible(const Factorization& candidate,
+                  const vector<const Factorization*>& other_candidates);
+  // Sets (*feasible)[k] to IsFeasible(candidates[k], all the other
+  // candidates), for each k. The rows for all the checks are added to the model
+  // once, and each check only changes row bounds before solving again.
+  void IsFeasibleBatch(const vector<const Factorization*>& candidates,
+                       vector<bool>* feasible);
+  const LinearProgrammingStats& GetStats() const {return stats;}
+  // Runs the solves of IsFeasibleBatch() on num_threads threads, each with its
+  // own backend. 0 or 1 runs them all on the calling thread, the default.
+  void SetNumThreads(unsigned int num_threads);
+  // The largest number of verdicts kept; 0 turns the VerdictCache off.
+  void SetVerdictCacheCapacity(size_t capacity) {
+    verdicts.SetCapacity(capacity);
   }
 };
 
 // Returns pairs of <1-indexed prime index, coefficient value> for the 
 // constraint row defined by f1 < f2,  ie. f2 - f1 > 0.
-vector<pair<int, double>> GetConstraintCoefficients(Factorization f1,
-                                                    Factorization f2);
+vector<pair<int, double>> GetConstraintCoefficients(const Factorization& f1,
+                                                    const Factorization& f2);
+// Returns whether f1 is a proper divisor of f2, ie. the exponent vector of f2
+// dominates that of f1 and they are not equal. Then f1 < f2 in every
+// sequence, since all the weights of the primes are positive.
+bool IsProperDivisor(const Factorization& f1, const Factorization& f2);
 // For print debugging.
 void PrintMatrixDebugString(int num_constraints, int num_primes,
                             int num_nonzero_elements, int* rowIndices,
                             int* colIndices, double* elements);
 bool IsFeasibleSequence(
     const vector<Factorization>& current_sequence,
-    Factorization candidate,
+    const Factorization& candidate,
     const vector<Factorization>& other_candidates);
+// Returns IsFeasibleSequence(current_sequence, candidates[k], all the other
+// candidates) for each k, using one model for all the checks.
+vector<bool> AreFeasibleCandidates(
+    const vector<Factorization>& current_sequence,
+    const vector<Factorization>& candidates);
 
 }  // namespace Platt
 
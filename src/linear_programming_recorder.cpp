@@ -0,0 +1,210 @@
+/*
+ * linear_programming_recorder.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the LinearProgrammingRecorder and LinearProgrammingLog classes.
+ */
+
+#include "linear_programming_recorder.h"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+namespace Platt {
+
+namespace {
+
+const char LOG_MAGIC[4] = {'P', 'L', 'P', 'R'};
+const char LOG_VERSION = 1;
+// More candidates in a check, or tuples in a factorization, than a log can
+// plausibly hold. A count above it means the log is corrupt.
+const uint64_t MAX_LOG_COUNT = 1 << 20;
+
+}  // namespace
+
+unsigned long LinearProgrammingRecorder::last_session = 0;
+LinearProgrammingRecorder* LinearProgrammingRecorder::active = nullptr;
+
+// The file is only opened once we know that no other recorder exists, so that
+// a second recorder does not truncate its file before throwing.
+LinearProgrammingRecorder::LinearProgrammingRecorder(const string& filename)
+    : num_contexts(0), session(0) {
+  if (active != nullptr)
+    throw(std::logic_error("Only one LinearProgrammingRecorder may exist."));
+  out.open(filename, std::ios::out | std::ios::binary);
+  if (!out)
+    throw(std::runtime_error("Cannot open " + filename + " for recording."));
+  out.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+  out.put(LOG_VERSION);
+  session = ++last_session;
+  active = this;
+}
+
+LinearProgrammingRecorder::~LinearProgrammingRecorder() {
+  active = nullptr;
+}
+
+void LinearProgrammingRecorder::WriteVarint(uint64_t value) {
+  while (value >= 0x80) {
+    out.put((char) ((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.put((char) value);
+}
+
+void LinearProgrammingRecorder::WriteFactorization(const Factorization& f) {
+  WriteVarint(f.GetFactors().size());
+  for (const Tuple& t : f.GetFactors()) {
+    WriteVarint(t.first);
+    WriteVarint(t.second);
+  }
+}
+
+void LinearProgrammingRecorder::RecordPush(unsigned int context,
+                                           const Factorization& f,
+                                           unsigned int num_primes) {
+  WriteVarint(PUSH_RECORD);
+  WriteVarint(context);
+  WriteVarint(num_primes);
+  WriteFactorization(f);
+}
+
+void LinearProgrammingRecorder::RecordPop(unsigned int context,
+                                          unsigned int num_primes) {
+  WriteVarint(POP_RECORD);
+  WriteVarint(context);
+  WriteVarint(num_primes);
+}
+
+void LinearProgrammingRecorder::RecordCheck(
+    unsigned int context, const vector<const Factorization*>& candidates,
+    const vector<CheckOutcome>& outcomes) {
+  WriteVarint(CHECK_RECORD);
+  WriteVarint(context);
+  WriteVarint(candidates.size());
+  for (const Factorization* f : candidates)
+    WriteFactorization(*f);
+  WriteVarint(outcomes.size());
+  for (const CheckOutcome& outcome : outcomes) {
+    WriteVarint(outcome.method * 2 + outcome.feasible);
+    WriteVarint(outcome.nanoseconds);
+  }
+}
+
+LinearProgrammingLog::LinearProgrammingLog(const string& filename)
+    : in(filename, std::ios::in | std::ios::binary), valid(false) {
+  char header[sizeof(LOG_MAGIC) + 1];
+  if (in.read(header, sizeof(header))) {
+    valid = std::equal(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC), header)
+            && header[sizeof(LOG_MAGIC)] == LOG_VERSION;
+  }
+}
+
+bool LinearProgrammingLog::ReadVarint(uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int c = in.get();
+    if (c == std::char_traits<char>::eof())
+      return false;
+    *value |= (uint64_t) (c & 0x7f) << shift;
+    if ((c & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+bool LinearProgrammingLog::ReadUnsigned(unsigned int* value) {
+  uint64_t wide;
+  if (!ReadVarint(&wide))
+    return false;
+  if (wide > UINT_MAX) {
+    valid = false;
+    return false;
+  }
+  *value = wide;
+  return true;
+}
+
+// The tuples are written in increasing order of their primes, as a
+// Factorization keeps them.
+bool LinearProgrammingLog::ReadFactorization(Factorization* f) {
+  uint64_t size;
+  if (!ReadVarint(&size))
+    return false;
+  if (size > MAX_LOG_COUNT) {
+    valid = false;
+    return false;
+  }
+  vector<Tuple> factors;
+  for (uint64_t i = 0; i < size; ++i) {
+    unsigned int prime, exponent;
+    if (!ReadUnsigned(&prime) || !ReadUnsigned(&exponent))
+      return false;
+    if (!factors.empty() && prime <= factors.back().first) {
+      valid = false;
+      return false;
+    }
+    factors.push_back(Tuple(prime, exponent));
+  }
+  *f = Factorization(factors);
+  return true;
+}
+
+bool LinearProgrammingLog::Read(LinearProgrammingRecord* record) {
+  if (!valid)
+    return false;
+  uint64_t type, value;
+  if (!ReadVarint(&type) || !ReadUnsigned(&record->context))
+    return false;
+  record->type = (RecordType) type;
+  record->factorizations.clear();
+  record->outcomes.clear();
+  switch (type) {
+    case PUSH_RECORD: {
+      if (!ReadUnsigned(&record->num_primes))
+        return false;
+      record->factorizations.push_back(Factorization());
+      return ReadFactorization(&record->factorizations.back());
+    }
+    case POP_RECORD: {
+      return ReadUnsigned(&record->num_primes);
+    }
+    case CHECK_RECORD: {
+      if (!ReadVarint(&value))
+        return false;
+      if (value > MAX_LOG_COUNT) {
+        valid = false;
+        return false;
+      }
+      // The candidates are added as they are read, so that a count that the
+      // rest of the log does not back up allocates little.
+      for (uint64_t i = 0; i < value; ++i) {
+        record->factorizations.push_back(Factorization());
+        if (!ReadFactorization(&record->factorizations.back()))
+          return false;
+      }
+      if (!ReadVarint(&value))
+        return false;
+      if (value > record->factorizations.size()) {
+        valid = false;
+        return false;
+      }
+      record->outcomes.resize(value);
+      for (CheckOutcome& outcome : record->outcomes) {
+        uint64_t verdict;
+        if (!ReadVarint(&verdict) || !ReadVarint(&outcome.nanoseconds))
+          return false;
+        outcome.feasible = verdict % 2 == 1;
+        outcome.method = (CheckMethod) (verdict / 2);
+      }
+      return true;
+    }
+    default:
+      valid = false;
+      return false;
+  }
+}
+
+}  // namespace Platt
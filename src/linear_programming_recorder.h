@@ -0,0 +1,140 @@
+/*
+ * linear_programming_recorder.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the LinearProgrammingRecorder class, which writes every check made
+ *  by the LinearProgrammingContexts of a run to a binary log, and the
+ *  LinearProgrammingLog class, which reads such a log back. The log is a
+ *  corpus of real instances for tuning the feasibility checks offline; see
+ *  bench_linear_programming.h for the replay benchmark.
+ *
+ *  Recording is turned on for as long as a recorder exists:
+ *      {
+ *        LinearProgrammingRecorder recorder("integer_tree_12.lplog");
+ *        IntegerTree tree(12);
+ *      }
+ *  Each context made while the recorder exists logs to it, and stops logging
+ *  when the recorder is destroyed. Only one recorder can exist at a time.
+ *
+ *  The log holds the pushes and pops of each context, rather than the whole
+ *  sequence for each check, which keeps it small. After a header of the 4
+ *  bytes "PLPR" and a version byte, it is a list of records. Every number in
+ *  them is an unsigned LEB128 varint, and a factorization is its number of
+ *  Tuples followed by the prime and exponent of each. A record starts with its
+ *  type and the id of its context, followed by
+ *    PUSH_RECORD:   the number of primes, then the factorization pushed.
+ *    POP_RECORD:    the number of primes after the pop.
+ *    CHECK_RECORD:  the number n of candidates and their factorizations, then
+ *                   the number m of candidates checked, which is n for
+ *                   IsFeasibleBatch() and 1 for IsFeasible() (whose candidate
+ *                   comes first), and for each of those the verdict, the
+ *                   CheckMethod that decided it, and the nanoseconds of its
+ *                   solve or cone check (0 when it was decided otherwise). The
+ *                   verdict and method share a byte: method * 2 + verdict.
+ */
+
+#ifndef LINEAR_PROGRAMMING_RECORDER_H_
+#define LINEAR_PROGRAMMING_RECORDER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "factorization.h"
+using std::string;
+using std::vector;
+
+namespace Platt {
+
+// How a LinearProgrammingContext decided a check.
+enum CheckMethod {
+  CONE_METHOD = 0,
+  WITNESS_METHOD = 1,
+  DOMINANCE_METHOD = 2,
+  CERTIFICATE_METHOD = 3,
+  VERDICT_CACHE_METHOD = 4,
+  SOLVE_METHOD = 5
+};
+
+enum RecordType {
+  PUSH_RECORD = 1,
+  POP_RECORD = 2,
+  CHECK_RECORD = 3
+};
+
+// The outcome of the check of one candidate.
+struct CheckOutcome {
+  bool feasible;
+  CheckMethod method;
+  uint64_t nanoseconds;
+};
+
+class LinearProgrammingRecorder {
+ private:
+  std::ofstream out;
+  unsigned int num_contexts;
+  // Incremented for each recorder, so that a context can tell whether the
+  // recorder it registered with still exists.
+  static unsigned long last_session;
+  static LinearProgrammingRecorder* active;
+  unsigned long session;
+
+  void WriteVarint(uint64_t value);
+  void WriteFactorization(const Factorization& f);
+
+ public:
+  explicit LinearProgrammingRecorder(const string& filename);
+  ~LinearProgrammingRecorder();
+  LinearProgrammingRecorder(const LinearProgrammingRecorder&) = delete;
+  LinearProgrammingRecorder& operator=(const LinearProgrammingRecorder&) =
+      delete;
+
+  // The recorder that exists, or nullptr.
+  static LinearProgrammingRecorder* Active() {return active;}
+  unsigned long Session() const {return session;}
+  // Returns the id for a new context.
+  unsigned int RegisterContext() {return num_contexts++;}
+  void RecordPush(unsigned int context, const Factorization& f,
+                  unsigned int num_primes);
+  void RecordPop(unsigned int context, unsigned int num_primes);
+  void RecordCheck(unsigned int context,
+                   const vector<const Factorization*>& candidates,
+                   const vector<CheckOutcome>& outcomes);
+};
+
+// One record of a log. Only the fields of its type are set.
+struct LinearProgrammingRecord {
+  RecordType type;
+  unsigned int context;
+  unsigned int num_primes;
+  // The factorization pushed, or the candidates of a check.
+  vector<Factorization> factorizations;
+  vector<CheckOutcome> outcomes;
+};
+
+class LinearProgrammingLog {
+ private:
+  std::ifstream in;
+  bool valid;
+
+  bool ReadVarint(uint64_t* value);
+  // Reads a varint that must fit in an unsigned int.
+  bool ReadUnsigned(unsigned int* value);
+  bool ReadFactorization(Factorization* f);
+
+ public:
+  explicit LinearProgrammingLog(const string& filename);
+  // Whether the file was opened and has the header of a log, and no corrupt
+  // record has been read from it.
+  bool IsValid() const {return valid;}
+  // Reads the next record into *record. Returns false at the end of the log,
+  // or if the rest of it cannot be read. A record with a count or value out
+  // of range, or a factorization with tuples out of order, is corrupt.
+  bool Read(LinearProgrammingRecord* record);
+};
+
+}  // namespace Platt
+
+#endif /* LINEAR_PROGRAMMING_RECORDER_H_ */
@@ -15,6 +15,8 @@
 #include "test_linear_programming.h"
 #include "test_multiplication_table.h"
 #include "test_random_walk.h"
+#include "bench_multiplication_table.h"
+#include "bench_linear_programming.h"
 #include "integer_tree.h"
 #include "prime_power_tree.h"
 #include "restricted_tree.h"
@@ -35,6 +37,7 @@ void BuildTree(IntegerTree** tree, unsigned int height);
 void BuildTree(PrimePowerTree** tree, unsigned int height);
 void BuildTree(RestrictedTree** tree, unsigned int height);
 void ExportAsDot(BeurlingTreeBase* tree, string filename);
+void PrintLinearProgrammingStats(BeurlingTreeBase* tree);
 void SerializeTree(BeurlingTreeBase* tree, string filename);
 void OpenTree(IntegerTree** serial_copy, string filename);
 void OpenTree(PrimePowerTree** serial_copy, string filename);
@@ -50,6 +53,9 @@ void DebugRandomWalk();
 
 int main() {
   RunTests();
+  //BenchmarkMultiplicationTable();
+  //RecordLinearProgramming("integer_tree_12.lplog", 12);
+  //BenchmarkLinearProgrammingReplay("integer_tree_12.lplog");
   //DemoIntegerTree();
 
   //DemoPrimePowerTree();
@@ -104,6 +110,7 @@ void BuildTree(IntegerTree** tree, unsigned int height) {
   time_t end = time(NULL);
   double seconds = difftime(end, begin);
   cout << "Built Tree in " << seconds << " seconds" << endl;
+  PrintLinearProgrammingStats(*tree);
 }
 
 void BuildTree(PrimePowerTree** tree, unsigned int height) {
@@ -113,6 +120,7 @@ void BuildTree(PrimePowerTree** tree, unsigned int height) {
   time_t end = time(NULL);
   double seconds = difftime(end, begin);
   cout << "Built Tree in " << seconds << " seconds" << endl;
+  PrintLinearProgrammingStats(*tree);
 }
 
 void BuildTree(RestrictedTree** tree, unsigned int height) {
@@ -122,6 +130,7 @@ void BuildTree(RestrictedTree** tree, unsigned int height) {
   time_t end = time(NULL);
   double seconds = difftime(end, begin);
   cout << "Built Tree in " << seconds << " seconds" << endl;
+  PrintLinearProgrammingStats(*tree);
 }
 
 void ExportAsDot(BeurlingTreeBase* tree, string filename) {
@@ -133,6 +142,21 @@ void ExportAsDot(BeurlingTreeBase* tree, string filename) {
   cout << "Exported to " << filename << " in " << seconds << " seconds" << endl;
 }
 
+void PrintLinearProgrammingStats(BeurlingTreeBase* tree) {
+  const LinearProgrammingStats& stats = tree->GetLinearProgrammingStats();
+  cout << "Linear programming checks:" << endl;
+  cout << "  dominated candidates: " << stats.dominated_candidates << endl;
+  cout << "  cone checks: " << stats.cone_checks << endl;
+  cout << "  witness hits: " << stats.witness_hits << endl;
+  cout << "  witness misses: " << stats.witness_misses << endl;
+  cout << "  certificate hits: " << stats.certificate_hits << endl;
+  cout << "  verdict hits: " << stats.verdict_hits << endl;
+  cout << "  verdict misses: " << stats.verdict_misses << endl;
+  cout << "  solves: " << stats.solves << endl;
+  cout << "Redundant rows: " << stats.redundant_rows << endl;
+  cout << "Certificates kept: " << stats.certificates << endl;
+}
+
 void SerializeTree(BeurlingTreeBase* tree, string filename){
   time_t begin = time(NULL);
   cout << "Serializing..." << endl;
@@ -7,13 +7,14 @@
  *  Defines the MultiplicationTable class.
  */
 
-#include <map>
-#include <set>
+#include <algorithm>
 #include "multiplication_table.h"
- #include "linear_programming.h"
+#include "linear_programming.h"
 #include "candidate.h"
-using std::multimap;
-using std::set;
+using std::copy;
+using std::lower_bound;
+using std::unique;
+using std::sort;
 
 namespace Platt {
 
@@ -34,32 +35,240 @@ Algorithm for determining "frontier" cells of the multiplication table:
     add (r+1,r+1) to the frontier
   return the frontier
 */
-vector<Tuple> MultiplicationTable::GetFrontier() const {
-  vector<Tuple> frontier;
-  for (size_t i = 1; i < table.size(); ++i) {
-    if (table[i].size() < table[i-1].size() -1)
-      frontier.push_back(Tuple(i, table[i].size()));
+// The frontier is kept up to date by PushFrontier() and PopFrontier(), so the
+// rows are never all scanned. Only the rows whose length changed and the rows
+// below them can enter or leave the frontier, or have a new frontier cell.
+MultiplicationTable::FrontierCell MultiplicationTable::ComputeFrontierCell(
+    unsigned int x) const {
+  FrontierCell cell;
+  cell.column = x < row_lengths.size() ? row_lengths[x] : 0;
+  cell.in_frontier = x <= row_lengths.size()
+                     && cell.column + 1 < row_lengths[x - 1];
+  return cell;
+}
+
+void MultiplicationTable::ToggleFrontierRow(unsigned int x) {
+  vector<unsigned int>::iterator it =
+      lower_bound(frontier_rows.begin(), frontier_rows.end(), x);
+  if (it != frontier_rows.end() && *it == x)
+    frontier_rows.erase(it);
+  else
+    frontier_rows.insert(it, x);
+}
+
+void MultiplicationTable::AddFrontierKey(FactorizationId f) {
+  unsigned int index = frontier_key_indices.FindOrInsert(
+      f, pool.GetHash(f), frontier_keys.size());
+  if (index == frontier_keys.size()) {
+    FrontierKey key;
+    key.factorization_id = f;
+    key.count = 0;
+    key.required_count = pool.Get(f).RequiredCount();
+    key.ready_position = -1;
+    frontier_keys.push_back(key);
+  }
+  FrontierKey& key = frontier_keys[index];
+  key.count++;
+  if (key.ready_position < 0 && key.count >= key.required_count) {
+    key.ready_position = ready_keys.size();
+    ready_keys.push_back(f);
+  }
+}
+
+void MultiplicationTable::RemoveFrontierKey(FactorizationId f) {
+  unsigned int index = *frontier_key_indices.Find(f, pool.GetHash(f));
+  FrontierKey& key = frontier_keys[index];
+  key.count--;
+  if (key.ready_position >= 0 && key.count < key.required_count) {
+    // Move the last ready key into its place.
+    FactorizationId last = ready_keys.back();
+    ready_keys[key.ready_position] = last;
+    frontier_keys[*frontier_key_indices.Find(last, pool.GetHash(last))]
+        .ready_position = key.ready_position;
+    ready_keys.pop_back();
+    key.ready_position = -1;
+  }
+  if (key.count == 0) {
+    // Move the last key into its place.
+    frontier_key_indices.Erase(f, pool.GetHash(f));
+    if (index + 1 < frontier_keys.size()) {
+      frontier_keys[index] = frontier_keys.back();
+      FactorizationId moved = frontier_keys[index].factorization_id;
+      *frontier_key_indices.Find(moved, pool.GetHash(moved)) = index;
+    }
+    frontier_keys.pop_back();
+  }
+}
+
+void MultiplicationTable::SetFrontierCell(unsigned int x,
+                                          const FrontierCell& cell) {
+  FrontierCell& old_cell = frontier_cells[x];
+  if (old_cell.in_frontier)
+    RemoveFrontierKey(old_cell.factorization_id);
+  if (cell.in_frontier)
+    AddFrontierKey(cell.factorization_id);
+  if (old_cell.in_frontier != cell.in_frontier)
+    ToggleFrontierRow(x);
+  old_cell = cell;
+}
+
+void MultiplicationTable::PushFrontier(const Candidate* c) {
+  frontier_marks.push_back(frontier_log.size());
+  if (frontier_cells.size() <= row_lengths.size())
+    frontier_cells.resize(row_lengths.size() + 1);
+
+  vector<unsigned int>& dirty_rows = update_scratch.dirty_rows;
+  dirty_rows.clear();
+  dirty_rows.push_back(1);
+  if (c) {
+    for (const Tuple& e : c->GetEntries()) {
+      dirty_rows.push_back(e.first);
+      dirty_rows.push_back(e.first + 1);
+    }
+  }
+  sort(dirty_rows.begin(), dirty_rows.end());
+  dirty_rows.erase(unique(dirty_rows.begin(), dirty_rows.end()),
+                   dirty_rows.end());
+
+  // Find the rows whose frontier cell changed, and compute the products of
+  // their new cells in one batch.
+  vector<unsigned int>& changed_rows = update_scratch.changed_rows;
+  vector<Tuple>& new_cells = update_scratch.new_cells;
+  changed_rows.clear();
+  new_cells.clear();
+  for (unsigned int x : dirty_rows) {
+    FrontierCell cell = ComputeFrontierCell(x);
+    const FrontierCell& old_cell = frontier_cells[x];
+    if (cell.in_frontier == old_cell.in_frontier
+        && (!cell.in_frontier || cell.column == old_cell.column))
+      continue;
+    changed_rows.push_back(x);
+    if (cell.in_frontier)
+      new_cells.emplace_back(x, cell.column);
+  }
+  vector<FactorizationId>& new_products = update_scratch.new_products;
+  GetFrontierProducts(new_cells, &new_products);
+
+  size_t next_product = 0;
+  for (unsigned int x : changed_rows) {
+    FrontierCell cell = ComputeFrontierCell(x);
+    cell.factorization_id = cell.in_frontier ? new_products[next_product++]
+                                             : 0;
+    frontier_log.push_back(pair<unsigned int, FrontierCell>(
+        x, frontier_cells[x]));
+    SetFrontierCell(x, cell);
+  }
+}
+
+void MultiplicationTable::PopFrontier() {
+  size_t mark = frontier_marks.back();
+  frontier_marks.pop_back();
+  while (frontier_log.size() > mark) {
+    SetFrontierCell(frontier_log.back().first, frontier_log.back().second);
+    frontier_log.pop_back();
   }
-  if (table.back().size() >= 2)
-    frontier.push_back(Tuple(table.size(),0));
-  return frontier;
 }
 
 // Sets prime_count to 0. Initializes table.
-MultiplicationTable::MultiplicationTable() {
-  table.push_back(vector<Cell>());
-  table[0].push_back(Cell(0,Factorization()));   // Identity
-  table[0].push_back(Cell(1,Factorization(0)));  // First Prime
+MultiplicationTable::MultiplicationTable(TableStorage storage)
+    : storage(storage), reserved_length(0) {
+  first_unpackable = 0;
+  row_lengths.push_back(0);
+  ReserveRows(INITIAL_RESERVED_LENGTH);
+  PushFirstRow(pool.Intern(Factorization()));   // Identity
+  PushFirstRow(pool.Intern(Factorization(0)));  // First Prime
   prime_count = 1;
+  linear_program.Push(Factorization(), prime_count);
+  linear_program.Push(Factorization(0), prime_count);
+  frontier_cells.resize(2);
+  PushFrontier(nullptr);
+  frontier_log.clear();
+  frontier_marks.clear();
+}
+
+void MultiplicationTable::PushFirstRow(FactorizationId f) {
+  bool all_packed = first_unpackable == first_row.size();
+  if (first_row.size() == reserved_length)
+    ReserveRows(2 * reserved_length);
+  first_row.emplace_back(f);
+  row_lengths[0]++;
+  packed_row.emplace_back();
+  if (Pack(pool.Get(f), &packed_row.back()) && all_packed)
+    first_unpackable = first_row.size();
+}
+
+void MultiplicationTable::PopFirstRow() {
+  first_row.pop_back();
+  row_lengths[0]--;
+  packed_row.pop_back();
+  if (first_unpackable > first_row.size())
+    first_unpackable = first_row.size();
+}
+
+// The products are computed in one batch from the packed first row when every
+// number in it can be packed, and the results are interned by their packed
+// form. Otherwise (or if an exponent of a product overflows) each product is
+// computed by the pool.
+void MultiplicationTable::GetFrontierProducts(
+    const vector<Tuple>& frontier, vector<FactorizationId>* cell_sums) {
+  cell_sums->resize(frontier.size());
+  if (first_unpackable == first_row.size()
+      && prime_count <= PackedExponents::MAX_PRIMES) {
+    unsigned int lanes = LanesForPrimes(prime_count);
+    vector<PackedExponents>& packed_sums = update_scratch.packed_sums;
+    vector<uint64_t>& packed_hashes = update_scratch.packed_hashes;
+    packed_sums.resize(frontier.size());
+    packed_hashes.resize(frontier.size());
+    if (AddFrontierProducts(packed_row.data(), frontier.data(),
+                            frontier.size(), lanes, packed_sums.data(),
+                            packed_hashes.data())) {
+      for (size_t i = 0; i < frontier.size(); ++i) {
+        (*cell_sums)[i] = pool.InternPacked(packed_sums[i], packed_hashes[i]);
+      }
+      return;
+    }
+  }
+  for (size_t i = 0; i < frontier.size(); ++i) {
+    const Tuple& t = frontier[i];
+    (*cell_sums)[i] = pool.Sum(first_row[t.first].factorization_id,
+                               first_row[t.first + t.second].factorization_id);
+  }
 }
 
-// Helper function for GetCandidates().
-vector<Factorization> MultiplicationTable::GetCurrentIntegerSequence() const {
-  vector<Factorization> current_integer_sequence;
-  for (Cell c : table[0]) {
-    current_integer_sequence.push_back(c.factors);
+void MultiplicationTable::ReserveRows(unsigned int length) {
+  if (length <= reserved_length)
+    return;
+  first_row.reserve(length);
+  packed_row.reserve(length);
+  if (storage == EXPLICIT_TABLE) {
+    vector<Cell> old_rows((size_t) length * (length - 1) / 2);
+    old_rows.swap(rows);
+    unsigned int old_length = reserved_length;
+    reserved_length = length;
+    for (size_t x = 1; x < row_lengths.size(); ++x) {
+      size_t old_offset = (x - 1) * old_length - x * (x - 1) / 2;
+      copy(old_rows.begin() + old_offset,
+           old_rows.begin() + old_offset + row_lengths[x],
+           rows.begin() + RowOffset(x));
+    }
   }
-  return current_integer_sequence;
+  reserved_length = length;
+}
+
+void MultiplicationTable::Reserve(unsigned int height) {
+  // The root of the tree is the first prime, so the first row holds the
+  // identity, the first prime and one number for each level below the root.
+  ReserveRows(height + 2);
+}
+
+FactorizationId MultiplicationTable::GetCell(unsigned int x,
+                                             unsigned int y) const {
+  if (x == 0)
+    return first_row[y].factorization_id;
+  if (storage == EXPLICIT_TABLE)
+    return rows[RowOffset(x) + y].factorization_id;
+  return pool.Sum(first_row[x].factorization_id,
+                  first_row[x + y].factorization_id);
 }
 
 /*
@@ -84,6 +293,9 @@ We also have the set of keys (factorizations).
 In this step we take the frontier cells and add them to the multimap of
 candidates. This collapses the set of cells so that all cells with the same
 factorization are collected together.
+(The implementation keeps the multimap as a live index, a hash table keyed by
+the factorization's id in the pool that counts the cells of each key, and
+updates it as cells enter and leave the frontier; see PushFrontier().)
 for each cell in frontier
   add cell to candidates multimap
   (add cell's key to the set of keys, which does not store duplicates)
@@ -109,42 +321,25 @@ for each factorization f in keys
 for each factorization f in keys_to_erase
   remove elements of candidates with key f
   (remove key f from keys)
+(The index also keeps the keys that have enough cells, so this step only reads
+them.)
 4.
 Return candidates.
 */
 vector<Candidate> MultiplicationTable::GetCandidates() const {
   vector<Candidate> final_candidates;
-  multimap<Factorization, Tuple> candidates;
-  set<Factorization> keys;
-
-  // 1. Determine frontier cells in table
-  vector<Tuple> frontier = GetFrontier();
-
-  // 2. Add frontier items to candidates
-  for (Tuple t : frontier) {
-    // Add item with the factorization that is the product of the two numbers
-    // referenced by its row and column indices
-    Factorization sum = table[0][t.first].factors
-                        + table[0][t.first + t.second].factors;
-    candidates.insert(pair<Factorization, Tuple>(sum, t));
-    keys.insert(sum);
-  }
+
+  // 1. and 2. are done as the table changes: frontier_rows holds the frontier
+  // and frontier_keys plays the role of the multimap of candidates, holding
+  // the number of cells of each key.
 
   // 3. Remove candidates
-  set<Factorization> keys_to_erase;
-  for (Factorization f : keys) {
-    unsigned int required_count = f.RequiredCount();
-    unsigned int current_count = candidates.count(f);
-    if (current_count < required_count)
-      keys_to_erase.insert(f);
-  }
-  for (Factorization f : keys_to_erase) {
-    candidates.erase(f);
-    keys.erase(f);
-  }
+  // The keys with enough cells are also kept up to date, in ready_keys.
+  vector<FactorizationId>& remaining_keys = scratch.remaining_keys;
+  remaining_keys.assign(ready_keys.begin(), ready_keys.end());
   // If the number of candidates for our next eventual composite is less than 1
   // we have a serious problem: no more composites!
-  if (keys.size() == 0) {
+  if (remaining_keys.size() == 0) {
     throw(
         CandidatesException(
             "Multiplication Table Exception: 0 composite candidates. (After RequiredCount check.)",
@@ -155,50 +350,72 @@ vector<Candidate> MultiplicationTable::GetCandidates() const {
 
   // Remove any candidate Factorizations that cause a cycle in the dependency
   // graph. We check this using linear programming.
-  set<Factorization> keys_to_erase_lp;
-  if (keys.size() > 1) {
-    for (Factorization candidiate_factorization : keys) {
-      vector<Factorization> other_candidate_factorizations;
-      for (Factorization f : keys) {
-        if (f != candidiate_factorization) {
-          other_candidate_factorizations.push_back(f);
-        }
-      }
-      if (!IsFeasibleSequence(GetCurrentIntegerSequence(),
-                              candidiate_factorization,
-                              other_candidate_factorizations)) {
-        keys_to_erase_lp.insert(candidiate_factorization);
+  vector<FactorizationId>& keys_to_erase_lp = scratch.keys_to_erase_lp;
+  keys_to_erase_lp.clear();
+  if (remaining_keys.size() > 1) {
+    vector<FactorizationId>& feasible_keys = scratch.feasible_keys;
+    vector<const Factorization*>& candidate_factorizations =
+        scratch.candidate_factorizations;
+    candidate_factorizations.clear();
+    for (FactorizationId key : remaining_keys)
+      candidate_factorizations.push_back(&pool.Get(key));
+    // All the checks share one model; see IsFeasibleBatch().
+    vector<bool>& feasible = scratch.feasible;
+    linear_program.IsFeasibleBatch(candidate_factorizations, &feasible);
+    feasible_keys.clear();
+    for (size_t i = 0; i < remaining_keys.size(); ++i) {
+      if (!feasible[i]) {
+        keys_to_erase_lp.push_back(remaining_keys[i]);
+      } else {
+        feasible_keys.push_back(remaining_keys[i]);
       }
     }
-    for (Factorization f : keys_to_erase_lp) {
-      candidates.erase(f);
-      keys.erase(f);
-    }
+    remaining_keys.swap(feasible_keys);
   }
 
   // If the number of candidates for our next eventual composite is less than 1
   // we have a serious problem: no more composites!
-  if (keys.size() == 0) {
+  if (remaining_keys.size() == 0) {
     string linear_programming_error_message = "Multiplication Table Exception: 0 composite candidates. (After Linear Programming check.)";
     linear_programming_error_message += "\nKeys removed using RequiredCount:\n";
-    for (Factorization f : keys_to_erase) {
-      linear_programming_error_message += f.ToDotString() + "\t";
+    for (const FrontierKey& key : frontier_keys) {
+      if (key.ready_position < 0) {
+        linear_programming_error_message +=
+            pool.Get(key.factorization_id).ToDotString() + "\t";
+      }
     }
     linear_programming_error_message += "\nKeys removed using Linear Programming:\n";
-    for (Factorization f : keys_to_erase_lp) {
-      linear_programming_error_message += f.ToDotString() + "\t";
+    for (FactorizationId f : keys_to_erase_lp) {
+      linear_programming_error_message += pool.Get(f).ToDotString() + "\t";
     }
     throw(CandidatesException(linear_programming_error_message, DebugString()));
   }
 
-  // Convert Multimap to vector
-  for (Factorization f : keys) {
-    Candidate c;
-    c.SetFactors(f);
-    auto range = candidates.equal_range(f);
-    for (auto it = range.first; it != range.second; it++)
-      c.AddEntry(it->second);
-    final_candidates.push_back(c);
+  // 4. Convert the remaining keys to Candidates. The candidates are returned in
+  // the lexicographical order of their factorizations (not the order of their
+  // ids), so that the order in which the trees explore them does not depend on
+  // the order in which factorizations were interned.
+  sort(remaining_keys.begin(), remaining_keys.end(),
+       [&] (FactorizationId lhs, FactorizationId rhs) {
+         return Factorization::LexicographicallyLess(pool.Get(lhs),
+                                                     pool.Get(rhs));
+       });
+  // The map gives the position of each remaining key in final_candidates.
+  FactorizationIdMap& key_positions = scratch.key_positions;
+  key_positions.Clear();
+  final_candidates.reserve(remaining_keys.size());
+  for (FactorizationId key : remaining_keys) {
+    key_positions.FindOrInsert(key, pool.GetHash(key),
+                               final_candidates.size());
+    final_candidates.emplace_back(key);
+  }
+  // Cells are added in frontier order.
+  for (unsigned int x : frontier_rows) {
+    const FrontierCell& cell = frontier_cells[x];
+    const unsigned int* position = key_positions.Find(
+        cell.factorization_id, pool.GetHash(cell.factorization_id));
+    if (position)
+      final_candidates[*position].EmplaceEntry(x, cell.column);
   }
 
   return final_candidates;
@@ -208,54 +425,88 @@ unsigned int MultiplicationTable::GetPrimeCount() const {
   return prime_count;
 }
 
+FactorizationId MultiplicationTable::Intern(const Factorization& f) {
+  return pool.Intern(f);
+}
+
+const Factorization& MultiplicationTable::GetFactorization(
+    FactorizationId id) const {
+  return pool.Get(id);
+}
+
+const FactorizationPool& MultiplicationTable::GetPool() const {
+  return pool;
+}
+
+const LinearProgrammingStats&
+MultiplicationTable::GetLinearProgrammingStats() const {
+  return linear_program.GetStats();
+}
+
+void MultiplicationTable::SetLinearProgrammingThreads(
+    unsigned int num_threads) {
+  linear_program.SetNumThreads(num_threads);
+}
+
+void MultiplicationTable::SetVerdictCacheCapacity(size_t capacity) {
+  linear_program.SetVerdictCacheCapacity(capacity);
+}
+
 // Note that the case  where a new row needs to be added to the table needs to
 // be watched for. We can't assume that the row exists. If one of the Candidates
 // has 0 for its accessor column index then a new row may need to be added.
 void MultiplicationTable::PushComposite(const Candidate& c) {
-  unsigned int next_number = table[0].size();
-  Factorization f = c.GetFactors();
+  FactorizationId f = c.GetFactorizationId();
   // Add item to first row.
-  table[0].push_back(Cell(next_number, f));
+  PushFirstRow(f);
+  linear_program.Push(pool.Get(f), prime_count);
   // Add the rest of the entries.
-  vector<Tuple> entries = c.GetEntries();
-  for (Tuple e : entries) {
-    while (e.first >= table.size())
-      table.push_back(vector<Cell>());
-    table[e.first].push_back(Cell(next_number, f));
+  for (const Tuple& e : c.GetEntries()) {
+    while (e.first >= row_lengths.size())
+      row_lengths.push_back(0);
+    if (storage == EXPLICIT_TABLE)
+      rows[RowOffset(e.first) + row_lengths[e.first]] = Cell(f);
+    row_lengths[e.first]++;
   }
+  PushFrontier(&c);
 }
 
 void MultiplicationTable::PopComposite(const Candidate& c) {
-  table[0].pop_back();
-  vector<Tuple> entries = c.GetEntries();
-  for (Tuple e : entries) {
-    table[e.first].pop_back();
+  PopFrontier();
+  linear_program.Pop(prime_count);
+  PopFirstRow();
+  for (const Tuple& e : c.GetEntries()) {
+    row_lengths[e.first]--;
   }
-  // We use the size of table (the number of rows) at other points in the
-  // algorithm. If there are empty rows we must delete them. Due to properties
-  // of the table, we should not have to worry about deleting a row in between
-  // rows; this condition should in theory only occur with the last row.
-  if (table.back().size() == 0)
-    table.pop_back();
+  // We use the number of rows at other points in the algorithm. If there are
+  // empty rows we must delete them. Due to properties of the table, we should
+  // not have to worry about deleting a row in between rows; this condition
+  // should in theory only occur with the last row.
+  if (row_lengths.back() == 0)
+    row_lengths.pop_back();
 }
 
 void MultiplicationTable::PushPrime() {
-  Factorization f = Factorization(prime_count);
-  table[0].push_back(Cell(table[0].size(), f));
+  FactorizationId f = pool.Intern(Factorization(prime_count));
+  PushFirstRow(f);
   prime_count++;
+  linear_program.Push(pool.Get(f), prime_count);
+  PushFrontier(nullptr);
 }
 
 void MultiplicationTable::PopPrime() {
+  PopFrontier();
   prime_count--;
-  table[0].pop_back();
+  linear_program.Pop(prime_count);
+  PopFirstRow();
 }
 
 string MultiplicationTable::DebugString() const {
   string out;
   out += "Printing table debug string\n";
-  for (size_t i = 0; i < table.size(); ++i) {
-    for (size_t j = 0; j < table[i].size(); ++j) {
-      out += "|" + table[i][j].factors.ToDotString() + "|";
+  for (size_t i = 0; i < row_lengths.size(); ++i) {
+    for (size_t j = 0; j < row_lengths[i]; ++j) {
+      out += "|" + pool.Get(GetCell(i, j)).ToDotString() + "|";
     }
     out += "\n";
   }
@@ -263,5 +514,32 @@ string MultiplicationTable::DebugString() const {
   return out;
 }
 
+string MultiplicationTable::FrontierDebugString() const {
+  string out;
+  out += "Frontier cells:\n";
+  for (unsigned int x : frontier_rows) {
+    const FrontierCell& cell = frontier_cells[x];
+    out += "(" + to_string(x) + "," + to_string(cell.column) + ") "
+        + pool.Get(cell.factorization_id).ToDotString() + "\n";
+  }
+  vector<string> keys;
+  for (const FrontierKey& key : frontier_keys) {
+    string line = pool.Get(key.factorization_id).ToDotString() + " "
+        + to_string(key.count) + "/" + to_string(key.required_count);
+    if (key.ready_position >= 0) {
+      // A ready key must be where its position says in ready_keys.
+      bool listed = (size_t) key.ready_position < ready_keys.size()
+          && ready_keys[key.ready_position] == key.factorization_id;
+      line += listed ? " ready" : " misplaced";
+    }
+    keys.push_back(line + "\n");
+  }
+  sort(keys.begin(), keys.end());
+  out += "Frontier keys (" + to_string(ready_keys.size()) + " ready):\n";
+  for (const string& key : keys)
+    out += key;
+  return out;
+}
+
 }  // namespace Platt
 
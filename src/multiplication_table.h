@@ -13,6 +13,9 @@
 
 #include <vector>
 #include "candidate.h"
+#include "factorization_id_map.h"
+#include "linear_programming.h"
+#include "packed_exponents.h"
 using std::vector;
 
 namespace Platt {
@@ -26,15 +29,24 @@ namespace Platt {
 // element, so any number that is in a cell in the table must necessarily
 // appear in the first row.
 
-// Cells in the table contains two members:
-// - A "position" indicating the index of the number in the first row.
-// - The unique prime factorization of the number in the Beurling generalized
-// integer system.
+// A cell in the table contains the unique prime factorization of its number in
+// the Beurling generalized integer system, as an id in the table's
+// FactorizationPool.
 struct Cell {
-  unsigned int position;
-  Factorization factors;
-  Cell(): position(), factors() {}
-  Cell(unsigned int p, Factorization f): position(p), factors(f) {}
+  FactorizationId factorization_id;
+  Cell(): factorization_id() {}
+  explicit Cell(FactorizationId f): factorization_id(f) {}
+};
+
+// How a MultiplicationTable stores the rows below the first one.
+enum TableStorage {
+  // Only the length of each row is stored. A cell (x,y) is the product of the
+  // cells (0,x) and (0,x+y), so its factorization is computed from the first
+  // row when it is needed. The table takes memory linear in the length of the
+  // first row.
+  IMPLICIT_TABLE,
+  // Every cell is stored.
+  EXPLICIT_TABLE
 };
 
 // An exception class to handle an error when no candidate composites are available.
@@ -90,12 +102,30 @@ class MultiplicationTable {
   //  table[x][y] can only be in the table if table[x-1][y+x] exists (for x > 0)
   // This property stems as a result of how the algorithm in the GetCandidates
   // function chooses candidates for additions to the table.
-  vector< vector<Cell> > table;
+  //
+  // The first row is first_row. row_lengths holds the length of every row
+  // (including the first) in both storage modes, and the number of rows is
+  // row_lengths.size().
+  //
+  // With EXPLICIT_TABLE storage the other rows are laid out one after another
+  // in the single array rows. Row x (x > 0) can hold at most
+  // reserved_length - x cells, where reserved_length bounds the length of the
+  // first row, since the property above gives that the length of row x is at
+  // most the length of the first row minus x. Row x therefore starts at
+  // RowOffset(x), and pushing or popping a cell never moves any other cell.
+  // If the first row outgrows reserved_length the rows are laid out again.
+  TableStorage storage;
+  vector<Cell> first_row;
+  vector<unsigned int> row_lengths;
+  vector<Cell> rows;
+  unsigned int reserved_length;
+  static const unsigned int INITIAL_RESERVED_LENGTH = 16;
 
   // Example:
   // The following is an example using the natural numbers as our integer
-  // system. We use the exponent vector form of factorization (with arrays of
-  // length two for formatting convenience only). Please note that this is just
+  // system. Each cell is shown as its position in the first row and the
+  // exponent vector form of its factorization (with arrays of length two for
+  // formatting convenience only); only the factorization is stored. Please note that this is just
   // a "cut-away" view of the table, not an actual state during the flow of the
   // algorithm, since there are values filled in which aren't yet occuring in
   // the top row.
@@ -154,25 +184,151 @@ class MultiplicationTable {
   // primes.
   unsigned int prime_count;
 
+  // Every factorization in the table, in the candidates and in the tree built
+  // from this table is interned here. The pool is mutable since GetCandidates()
+  // interns the products it computes; this does not change the state of the
+  // table itself.
+  mutable FactorizationPool pool;
+
+  // The packed form of each number in the first row, so that the products of
+  // the frontier cells can be computed in one batch (see packed_exponents.h).
+  // first_unpackable is the position of the first number in the first row that
+  // cannot be packed, or the length of the first row if there is none. While
+  // there is one, the products are computed with the pool instead.
+  vector<PackedExponents> packed_row;
+  size_t first_unpackable;
+
+  // The frontier cell of a row: the next cell (x,column) of row x, if it is
+  // in the frontier, and its factorization.
+  struct FrontierCell {
+    bool in_frontier;
+    unsigned int column;
+    FactorizationId factorization_id;
+    FrontierCell(): in_frontier(false), column(0), factorization_id(0) {}
+  };
+  // The frontier cell of each row x > 0, indexed by x. Row x is in the
+  // frontier if and only if it is shorter than row x-1 less one, where the row
+  // just past the last row counts as a row of length 0. Pushing or popping
+  // only changes the lengths of row 0 and of the rows of the candidate's
+  // entries, so only row 1 and the rows r and r+1 for each entry row r need to
+  // be checked again.
+  vector<FrontierCell> frontier_cells;
+  // The rows that are in the frontier, in increasing order.
+  vector<unsigned int> frontier_rows;
+  // An undo log for frontier_cells: the rows that each push changed, with
+  // their previous frontier cells. frontier_marks holds the start of the log
+  // of each push.
+  vector< pair<unsigned int, FrontierCell> > frontier_log;
+  vector<size_t> frontier_marks;
+
+  // The live index of the frontier: each distinct factorization of the
+  // frontier cells (a "key"), with its number of cells and its
+  // RequiredCount(). frontier_key_indices gives the index of a key in
+  // frontier_keys.
+  struct FrontierKey {
+    FactorizationId factorization_id;
+    unsigned int count;
+    unsigned int required_count;
+    // The position of the key in ready_keys, or -1 if it is not there.
+    int ready_position;
+  };
+  FactorizationIdMap frontier_key_indices;
+  vector<FrontierKey> frontier_keys;
+  // The keys whose count has reached their required count, in no particular
+  // order. These are the candidates before the linear programming check.
+  vector<FactorizationId> ready_keys;
+
+  // Scratch space for PushFrontier().
+  struct UpdateScratch {
+    vector<unsigned int> dirty_rows;
+    vector<unsigned int> changed_rows;
+    vector<Tuple> new_cells;
+    vector<FactorizationId> new_products;
+    vector<PackedExponents> packed_sums;
+    vector<uint64_t> packed_hashes;
+  };
+  UpdateScratch update_scratch;
+
+  // Scratch space for GetCandidates(). It is kept between calls so that, once
+  // the vectors have grown to their working size, a call only allocates for
+  // the Candidates it returns and for the linear programming check.
+  struct CandidatesScratch {
+    vector<FactorizationId> remaining_keys;
+    vector<FactorizationId> feasible_keys;
+    vector<FactorizationId> keys_to_erase_lp;
+    FactorizationIdMap key_positions;
+    vector<const Factorization*> candidate_factorizations;
+    vector<bool> feasible;
+  };
+  mutable CandidatesScratch scratch;
+
+  // The linear program for the checks in GetCandidates(). It holds the
+  // constraints for the numbers of the first row, and follows every push and
+  // pop. It is mutable since each check adds and then removes the rows of the
+  // candidates.
+  mutable LinearProgrammingContext linear_program;
+
   // Recall that table[x][y] corresponds to cell (x,y+x) = (i,j) in the table,
   // where x,y are accessor indices and i,j are table indices. In this program
   // we will always use accessor indices.
 
-  // Returns the "frontier", the list of cells in the table where we might
-  // possibly place the next number in our sequence of integers.
-  vector<Tuple> GetFrontier() const;
+  // The frontier cell of row x (without its factorization) for the current
+  // row lengths.
+  FrontierCell ComputeFrontierCell(unsigned int x) const;
+  // Adds or removes row x from frontier_rows.
+  void ToggleFrontierRow(unsigned int x);
+  // Add or remove one cell of factorization f in the live index.
+  void AddFrontierKey(FactorizationId f);
+  void RemoveFrontierKey(FactorizationId f);
+  // Replaces the frontier cell of row x, updating the live index.
+  void SetFrontierCell(unsigned int x, const FrontierCell& cell);
+  // Updates the frontier after a push of c (or of a prime, if c is null).
+  void PushFrontier(const Candidate* c);
+  // Reverts the update of the last push.
+  void PopFrontier();
+
+  // Sets cell_sums to the ids of the products of the given cells.
+  void GetFrontierProducts(const vector<Tuple>& frontier,
+                           vector<FactorizationId>* cell_sums);
+
+  // Keep packed_row in step with the first row of the table.
+  void PushFirstRow(FactorizationId f);
+  void PopFirstRow();
+
+  // The position in rows of the first cell of row x, for x > 0.
+  size_t RowOffset(unsigned int x) const {
+    return (size_t) (x - 1) * reserved_length - (size_t) x * (x - 1) / 2;
+  }
+  // Lays out rows again for a first row of length at most length.
+  void ReserveRows(unsigned int length);
+
+  // The factorization in cell (x,y), using accessor indices.
+  FactorizationId GetCell(unsigned int x, unsigned int y) const;
 
-  // Helper function for a linear programming task.
-  vector<Factorization> GetCurrentIntegerSequence() const;
 
  public:
 
   // Sets prime_count to 0. Initializes table.
-  MultiplicationTable();
+  explicit MultiplicationTable(TableStorage storage = IMPLICIT_TABLE);
+  // Reserves room for a table that will hold the numbers of a path of the
+  // given height in the tree, so that growing the table does not allocate.
+  void Reserve(unsigned int height);
   // Function GetCandidates() returns the child composites of a node with the 
   // associated state of the MultiplicationTable.
   vector<Candidate> GetCandidates() const;
   unsigned int GetPrimeCount() const;
+  // Returns the id of f in the table's FactorizationPool, adding it if needed.
+  FactorizationId Intern(const Factorization& f);
+  const Factorization& GetFactorization(FactorizationId id) const;
+  const FactorizationPool& GetPool() const;
+  // Counts of the linear programming work done by GetCandidates().
+  const LinearProgrammingStats& GetLinearProgrammingStats() const;
+  // Runs the linear programs of GetCandidates() on num_threads threads (see
+  // LinearProgrammingContext::SetNumThreads()).
+  void SetLinearProgrammingThreads(unsigned int num_threads);
+  // Keeps up to capacity verdicts of those linear programs; 0, the default,
+  // keeps none (see LinearProgrammingContext::SetVerdictCacheCapacity()).
+  void SetVerdictCacheCapacity(size_t capacity);
   void PushComposite(const Candidate&);
   void PopComposite(const Candidate&);
   void PushPrime();
@@ -180,6 +336,9 @@ class MultiplicationTable {
 
   // For debugging:
   string DebugString() const;
+  // The frontier cells, and the live index of their factorizations listed by
+  // factorization, so that it does not depend on the order of the pushes.
+  string FrontierDebugString() const;
 };
 
 }  // namespace Platt
@@ -7,8 +7,11 @@
  *  This file declares and defines inline the Node class, which is used in the
  *  Tree class.
  *
- *  For our purposes, a functor is a functor that takes Node* as its parameter
- *  and must have an operator which takes the argument:  Node<T>* N.
+ *  A node lives in the NodeArena of its Tree, and refers to other nodes by
+ *  their 32-bit NodeHandles: its children form a list, from first_child along
+ *  the next_sibling of each, in the order the Tree keeps them in. It follows
+ *  the links, so a node is only its data and three handles (and is trivially
+ *  destructible when T is).
  *
  *  Implementation is inlined in the header since it is short.
  */
@@ -16,42 +19,37 @@
 #ifndef NODE_H_
 #define NODE_H_
 
-#include<vector>
-using std::vector;
-#include <map>
-using std::map;
+#include <cstdint>
 
 namespace Platt {
 
+typedef uint32_t NodeHandle;
+// The handle of no node.
+const NodeHandle NO_NODE = UINT32_MAX;
+
+template <class T>
+class Tree;
+
 template <class T>
 class Node{
  private:
   T data;
-  map< T, Node<T>* > nodes;
+  NodeHandle first_child;
+  // Kept so that children are appended in O(1).
+  NodeHandle last_child;
+  NodeHandle next_sibling;
+
+  friend class Tree<T>;
 
  public:
-  Node() {}
-  Node(T Data){data=Data;}
-  void SetData(T Data) {data = Data;}
-  void Add(Node* N) {nodes.insert(std::pair<T,Node<T>*>(N->data,N));}
-  T GetData() const {return data;}
+  Node() : first_child(NO_NODE), last_child(NO_NODE), next_sibling(NO_NODE) {}
+  Node(const T& Data)
+      : data(Data), first_child(NO_NODE), last_child(NO_NODE),
+        next_sibling(NO_NODE) {}
+  void SetData(const T& Data) {data = Data;}
+  const T& GetData() const {return data;}
   T* GetDataPtr() {return &data;}
-  vector< Node<T>* > GetChildren() {
-    vector< Node<T>* > children_vector;
-    for(auto it = nodes.begin(); it != nodes.end(); ++it)
-      children_vector.push_back(it->second);
-    return children_vector;
-  }
-  Node<T>* GetChild (const T& in) {return nodes[in];}
-  bool Childless(){return nodes.size()==0;}
-  bool HasChild (const T& in) {return nodes.count(in) == 1;}
-
-  template <class functor>
-  void Iterate(functor& f) {
-    for (auto &child : nodes) {
-      f(child.second);  // child.second is the child node
-    }
-  }
+  bool Childless() const {return first_child == NO_NODE;}
 };
 
 }  // namespace Platt
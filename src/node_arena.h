@@ -0,0 +1,85 @@
+/*
+ * node_arena.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares and defines inline the NodeArena class, which owns the nodes of a
+ *  Tree. Nodes are placed in fixed-size chunks that are never moved, so a node
+ *  stays at the same address for the life of the arena, and each node is also
+ *  addressed by a 32-bit NodeHandle (see node.h), its index in the order of
+ *  allocation. Nodes are never freed one at a time: Clear() and the destructor
+ *  release the chunks whole, without visiting the nodes at all when Node<T>
+ *  has a trivial destructor.
+ *
+ *  Implementation is inlined in the header since it is short.
+ */
+
+#ifndef NODE_ARENA_H_
+#define NODE_ARENA_H_
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "node.h"
+using std::vector;
+
+namespace Platt {
+
+template <class T>
+class NodeArena {
+ private:
+  // Each chunk holds 2^CHUNK_BITS nodes.
+  static const unsigned int CHUNK_BITS = 12;
+  static const NodeHandle CHUNK_SIZE = (NodeHandle) 1 << CHUNK_BITS;
+  typedef typename std::aligned_storage<sizeof(Node<T>),
+                                        alignof(Node<T>)>::type Slot;
+
+  vector< std::unique_ptr<Slot[]> > chunks;
+  NodeHandle size;
+
+  Node<T>* SlotAt(NodeHandle h) const {
+    return reinterpret_cast<Node<T>*>(
+        &chunks[h >> CHUNK_BITS][h & (CHUNK_SIZE - 1)]);
+  }
+
+  void DestroyNodes() {
+    if (!std::is_trivially_destructible< Node<T> >::value) {
+      for (NodeHandle h = 0; h < size; ++h)
+        SlotAt(h)->~Node<T>();
+    }
+  }
+
+ public:
+  NodeArena() : size(0) {}
+  NodeArena(const NodeArena&) = delete;
+  NodeArena& operator=(const NodeArena&) = delete;
+  ~NodeArena() {DestroyNodes();}
+
+  // Places a new node holding data in the arena, and returns its handle.
+  NodeHandle New(const T& data) {
+    if (size == NO_NODE)
+      throw(std::length_error("A NodeArena cannot hold more nodes."));
+    if ((size >> CHUNK_BITS) == chunks.size())
+      chunks.emplace_back(new Slot[CHUNK_SIZE]);
+    new (SlotAt(size)) Node<T>(data);
+    return size++;
+  }
+
+  Node<T>* Get(NodeHandle h) const {return SlotAt(h);}
+  NodeHandle Size() const {return size;}
+
+  // Frees every node. The chunks are released too, so that clearing a large
+  // tree gives its memory back.
+  void Clear() {
+    DestroyNodes();
+    chunks.clear();
+    size = 0;
+  }
+};
+
+}  // namespace Platt
+
+#endif /* NODE_ARENA_H_ */
@@ -0,0 +1,196 @@
+/*
+ * packed_exponents.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the functions declared in packed_exponents.h.
+ */
+
+#include "packed_exponents.h"
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+using std::memcmp;
+using std::memcpy;
+using std::memset;
+
+namespace Platt {
+
+namespace {
+
+// The multipliers of the hash. Lane i is read as four 32-bit words, and word j
+// is multiplied by HASH_KEYS[i][j] into a 64-bit accumulator (words 0 and 1
+// into the first, words 2 and 3 into the second). A lane of zeros therefore
+// adds nothing to the hash.
+const uint32_t HASH_KEYS[PackedExponents::MAX_LANES][4] = {
+  {0x9E3779B1u, 0x85EBCA77u, 0xC2B2AE3Du, 0x27D4EB2Fu},
+  {0x165667B1u, 0xD3A2646Du, 0xFD7046C5u, 0xB55A4F09u},
+  {0x8CB92BA7u, 0x5BD1E995u, 0xCC9E2D51u, 0x1B873593u},
+  {0xE6546B65u, 0x85EBCA6Bu, 0xC2B2AE35u, 0x9E3779B9u}
+};
+
+// Finishes a hash from the two accumulators (the SplitMix64 finalizer).
+inline uint64_t FinishHash(uint64_t first, uint64_t second) {
+  uint64_t h = first ^ ((second << 31) | (second >> 33));
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  return h ^ (h >> 31);
+}
+
+#if defined(__AVX2__)
+
+// Lanes are processed in pairs. Since the bytes past the used lanes are zero,
+// processing one lane too many does not change any result.
+const unsigned int STEP = 2;
+
+inline uint64_t HashVector(const uint8_t* bytes, unsigned int lanes) {
+  __m256i acc = _mm256_setzero_si256();
+  for (unsigned int i = 0; i < lanes; i += STEP) {
+    __m256i x = _mm256_loadu_si256((const __m256i*) (bytes + 16 * i));
+    __m256i k = _mm256_loadu_si256((const __m256i*) HASH_KEYS[i]);
+    acc = _mm256_add_epi64(acc, _mm256_mul_epu32(x, k));
+    acc = _mm256_add_epi64(acc, _mm256_mul_epu32(_mm256_srli_epi64(x, 32),
+                                                  _mm256_srli_epi64(k, 32)));
+  }
+  uint64_t words[4];
+  _mm256_storeu_si256((__m256i*) words, acc);
+  return FinishHash(words[0] + words[2], words[1] + words[3]);
+}
+
+#elif defined(__SSE2__)
+
+const unsigned int STEP = 1;
+
+inline uint64_t HashVector(const uint8_t* bytes, unsigned int lanes) {
+  __m128i acc = _mm_setzero_si128();
+  for (unsigned int i = 0; i < lanes; ++i) {
+    __m128i x = _mm_loadu_si128((const __m128i*) (bytes + 16 * i));
+    __m128i k = _mm_loadu_si128((const __m128i*) HASH_KEYS[i]);
+    acc = _mm_add_epi64(acc, _mm_mul_epu32(x, k));
+    acc = _mm_add_epi64(acc, _mm_mul_epu32(_mm_srli_epi64(x, 32),
+                                           _mm_srli_epi64(k, 32)));
+  }
+  uint64_t words[2];
+  _mm_storeu_si128((__m128i*) words, acc);
+  return FinishHash(words[0], words[1]);
+}
+
+#else
+
+const unsigned int STEP = 1;
+
+inline uint64_t HashVector(const uint8_t* bytes, unsigned int lanes) {
+  uint64_t first = 0, second = 0;
+  for (unsigned int i = 0; i < lanes; ++i) {
+    uint32_t x[4];
+    memcpy(x, bytes + 16 * i, sizeof(x));
+    first += (uint64_t) x[0] * HASH_KEYS[i][0]
+             + (uint64_t) x[1] * HASH_KEYS[i][1];
+    second += (uint64_t) x[2] * HASH_KEYS[i][2]
+              + (uint64_t) x[3] * HASH_KEYS[i][3];
+  }
+  return FinishHash(first, second);
+}
+
+#endif
+
+// The number of lanes actually processed for lanes requested lanes.
+inline unsigned int ProcessedLanes(unsigned int lanes) {
+  return (lanes + STEP - 1) / STEP * STEP;
+}
+
+// Adds lhs and rhs into sum. Returns false if an exponent overflowed. A sum of
+// 255 is also reported as an overflow, since it cannot be told apart from a
+// saturated one.
+inline bool AddVectors(const uint8_t* lhs, const uint8_t* rhs, uint8_t* sum,
+                       unsigned int lanes) {
+#if defined(__AVX2__)
+  const __m256i saturated = _mm256_set1_epi8((char) 0xFF);
+  int overflow = 0;
+  for (unsigned int i = 0; i < lanes; i += STEP) {
+    __m256i s = _mm256_adds_epu8(
+        _mm256_loadu_si256((const __m256i*) (lhs + 16 * i)),
+        _mm256_loadu_si256((const __m256i*) (rhs + 16 * i)));
+    overflow |= _mm256_movemask_epi8(_mm256_cmpeq_epi8(s, saturated));
+    _mm256_storeu_si256((__m256i*) (sum + 16 * i), s);
+  }
+  return overflow == 0;
+#elif defined(__SSE2__)
+  const __m128i saturated = _mm_set1_epi8((char) 0xFF);
+  int overflow = 0;
+  for (unsigned int i = 0; i < lanes; ++i) {
+    __m128i s = _mm_adds_epu8(_mm_loadu_si128((const __m128i*) (lhs + 16 * i)),
+                              _mm_loadu_si128((const __m128i*) (rhs + 16 * i)));
+    overflow |= _mm_movemask_epi8(_mm_cmpeq_epi8(s, saturated));
+    _mm_storeu_si128((__m128i*) (sum + 16 * i), s);
+  }
+  return overflow == 0;
+#else
+  bool ok = true;
+  for (unsigned int i = 0; i < 16 * lanes; ++i) {
+    unsigned int s = (unsigned int) lhs[i] + rhs[i];
+    ok &= s < 255;
+    sum[i] = (uint8_t) s;
+  }
+  return ok;
+#endif
+}
+
+}  // namespace
+
+bool Pack(const Factorization& f, PackedExponents* packed) {
+  memset(packed->exponents, 0, PackedExponents::MAX_PRIMES);
+  for (const Tuple& t : f.GetFactors()) {
+    if (t.first >= PackedExponents::MAX_PRIMES || t.second >= 255) {
+      memset(packed->exponents, 0, PackedExponents::MAX_PRIMES);
+      return false;
+    }
+    packed->exponents[t.first] = (uint8_t) t.second;
+  }
+  return true;
+}
+
+Factorization Unpack(const PackedExponents& packed) {
+  TupleVector factors;
+  for (unsigned int i = 0; i < PackedExponents::MAX_PRIMES; ++i) {
+    if (packed.exponents[i] != 0)
+      factors.push_back(Tuple(i, packed.exponents[i]));
+  }
+  // The identity is stored as {(0,0)}.
+  if (factors.empty())
+    return Factorization();
+  return Factorization(factors);
+}
+
+uint64_t HashPacked(const PackedExponents& packed, unsigned int lanes) {
+  return HashVector(packed.exponents, ProcessedLanes(lanes));
+}
+
+bool PackedEqual(const PackedExponents& lhs, const PackedExponents& rhs,
+                 unsigned int lanes) {
+  return memcmp(lhs.exponents, rhs.exponents,
+                PackedExponents::LANE_SIZE * lanes) == 0;
+}
+
+bool AddFrontierProducts(const PackedExponents* row, const Tuple* cells,
+                         size_t n, unsigned int lanes, PackedExponents* sums,
+                         uint64_t* hashes) {
+  unsigned int processed = ProcessedLanes(lanes);
+  size_t used_bytes = PackedExponents::LANE_SIZE * processed;
+  bool ok = true;
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t* sum = sums[i].exponents;
+    ok &= AddVectors(row[cells[i].first].exponents,
+                     row[cells[i].first + cells[i].second].exponents, sum,
+                     processed);
+    memset(sum + used_bytes, 0, PackedExponents::MAX_PRIMES - used_bytes);
+    hashes[i] = HashVector(sum, processed);
+  }
+  return ok;
+}
+
+}  // namespace Platt
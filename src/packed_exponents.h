@@ -0,0 +1,69 @@
+/*
+ * packed_exponents.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the PackedExponents struct, a dense exponent vector form of a
+ *  factorization with one byte per prime, and the batched kernel that the
+ *  MultiplicationTable uses to compute all the products of its frontier cells
+ *  at once.
+ *
+ *  The Tuple form (see factorization.h) remains the general representation. A
+ *  factorization can only be packed if all of its primes have an index below
+ *  MAX_PRIMES and all of its exponents are below 255; otherwise the table
+ *  falls back to adding Factorizations one at a time.
+ *
+ *  The exponents are handled in 16-byte "lanes". Only the lanes that hold
+ *  primes of the current table need to be processed; the bytes past them are
+ *  always zero. The kernels use SSE2 or AVX2 when the compiler targets them,
+ *  and a scalar loop otherwise. All versions give identical results.
+ */
+
+#ifndef PACKED_EXPONENTS_H_
+#define PACKED_EXPONENTS_H_
+
+#include <cstdint>
+#include "factorization.h"
+
+namespace Platt {
+
+struct PackedExponents {
+  static const unsigned int MAX_PRIMES = 64;
+  static const unsigned int LANE_SIZE = 16;
+  static const unsigned int MAX_LANES = MAX_PRIMES / LANE_SIZE;
+  // exponents[i] is the exponent of the prime with (0-based) index i.
+  uint8_t exponents[MAX_PRIMES];
+};
+
+// The number of lanes needed to hold prime_count primes.
+inline unsigned int LanesForPrimes(unsigned int prime_count) {
+  return (prime_count + PackedExponents::LANE_SIZE - 1)
+         / PackedExponents::LANE_SIZE;
+}
+
+// Packs f into packed. Returns false (leaving packed zeroed) if f cannot be
+// represented.
+bool Pack(const Factorization& f, PackedExponents* packed);
+Factorization Unpack(const PackedExponents& packed);
+
+// A hash of the first lanes of packed. Lanes that are all zero do not change
+// the hash, so the hash of a vector does not depend on the number of lanes
+// used, as long as that number covers all its nonzero exponents.
+uint64_t HashPacked(const PackedExponents& packed, unsigned int lanes);
+bool PackedEqual(const PackedExponents& lhs, const PackedExponents& rhs,
+                 unsigned int lanes);
+
+// Computes, for each of the n frontier cells (x,y) (using the accessor indices
+// of the MultiplicationTable), the product row[x] + row[x+y] into sums and its
+// HashPacked() into hashes. Only the first lanes lanes of each vector are read
+// and written; the remaining bytes of sums are set to zero. Returns false if
+// any exponent of a product does not fit, in which case the contents of sums
+// and hashes must not be used.
+bool AddFrontierProducts(const PackedExponents* row, const Tuple* cells,
+                         size_t n, unsigned int lanes, PackedExponents* sums,
+                         uint64_t* hashes);
+
+}  // namespace Platt
+
+#endif /* PACKED_EXPONENTS_H_ */
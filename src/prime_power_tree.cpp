@@ -15,7 +15,9 @@ PrimePowerTree::PrimePowerTree() {
   InitDefault();
 }
 
-PrimePowerTree::PrimePowerTree(unsigned int height) {
+PrimePowerTree::PrimePowerTree(unsigned int height,
+                               size_t verdict_cache_capacity) {
+  table.SetVerdictCacheCapacity(verdict_cache_capacity);
   InitToHeight(height);
 }
 
@@ -31,21 +33,18 @@ void PrimePowerTree::NextLevel() {}
  * in order to get the PrimePowerTree to the desired height.
  */
 void PrimePowerTree::RecursiveBuild(unsigned int height,
-                                    Node<Factorization>* n) {
+                                    Node<FactorizationId>* n) {
   if (height > 0) {
     // Add composites and recurse
     vector<Candidate> candidates = table.GetCandidates();
-    for(Candidate c : candidates) {
-      if (c.GetFactors().IsPrimePower()) {
-        Node<Factorization>* child;
+    for(const Candidate& c : candidates) {
+      if (table.GetFactorization(c.GetFactorizationId()).IsPrimePower()) {
         // If factorization is not already a child of n, add it as a child.
-        if (!n->HasChild(c.GetFactors())) {
-          child = new Node<Factorization>(c.GetFactors());
-          n->Add(child);
-        }
-        else {  // Otherwise, get the existing child.
-          child = n->GetChild(c.GetFactors());
-        }
+        // Otherwise, get the existing child.
+        Node<FactorizationId>* child =
+            tree.GetChild(n, c.GetFactorizationId());
+        if (child == nullptr)
+          child = AddChildInOrder(n, c.GetFactorizationId());
         if (height > 1) {
           table.PushComposite(c);
           RecursiveBuild(height - 1, child);
@@ -59,10 +58,12 @@ void PrimePowerTree::RecursiveBuild(unsigned int height,
       }
     }
 
-    // Add prime and recurse
-    Node<Factorization>* child = new Node<Factorization>(
-                                         Factorization(table.GetPrimeCount()));
-    n->Add(child);
+    // Add prime and recurse, unless n already has it as a child, which
+    // happens when n was added before and is being built on again.
+    FactorizationId prime = table.Intern(Factorization(table.GetPrimeCount()));
+    if (tree.HasChild(n, prime))
+      return;
+    Node<FactorizationId>* child = AddChildInOrder(n, prime);
     if (height > 1) {
       table.PushPrime();
       RecursiveBuild(height - 1, child);
@@ -73,14 +74,18 @@ void PrimePowerTree::RecursiveBuild(unsigned int height,
 
 // Same as RecursiveBuild, but without adding a prime
 void PrimePowerTree::RecursiveBuildContinue(unsigned int height,
-                                    Node<Factorization>* n) {
+                                    Node<FactorizationId>* n) {
   if (height > 0) {
     // Add composites and recurse
     vector<Candidate> candidates = table.GetCandidates();
-    for(Candidate c : candidates) {
-      if (c.GetFactors().IsPrimePower()) {
-        Node<Factorization>* child = new Node<Factorization>(c.GetFactors());
-        n->Add(child);
+    for(const Candidate& c : candidates) {
+      if (table.GetFactorization(c.GetFactorizationId()).IsPrimePower()) {
+        // A prime power that n already has as a child is not added again,
+        // nor built on.
+        if (tree.HasChild(n, c.GetFactorizationId()))
+          continue;
+        Node<FactorizationId>* child =
+            AddChildInOrder(n, c.GetFactorizationId());
         if (height > 1) {
           table.PushComposite(c);
           RecursiveBuild(height - 1, child);
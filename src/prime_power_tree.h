@@ -18,13 +18,16 @@ namespace Platt {
 
 class PrimePowerTree : public BeurlingTreeBase {
  private:
-  void RecursiveBuild(unsigned int height, Node<Factorization>* n);
-  void RecursiveBuildContinue(unsigned int height, Node<Factorization>* n);
+  void RecursiveBuild(unsigned int height, Node<FactorizationId>* n);
+  void RecursiveBuildContinue(unsigned int height, Node<FactorizationId>* n);
 
  public:
   // Default Constructor initializes with just a root node.
   PrimePowerTree();
-  PrimePowerTree(unsigned int height);
+  // A verdict_cache_capacity above 0 keeps that many linear programming
+  // verdicts, for the composites that RecursiveBuildContinue() explores again.
+  PrimePowerTree(unsigned int height, size_t verdict_cache_capacity =
+                 LinearProgrammingContext::DEFAULT_VERDICT_CACHE_CAPACITY);
   // Construct from deserialization of a file
   PrimePowerTree(string filename);
   // TODO: implement NextLevel().
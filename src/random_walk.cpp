@@ -28,10 +28,11 @@ RandomWalk::RandomWalk() {
   InitDefault();
 }
 
-RandomWalk::RandomWalk(unsigned int height) {
+RandomWalk::RandomWalk(unsigned int height, unsigned int lp_threads) {
+  table.SetLinearProgrammingThreads(lp_threads);
   number_primes.push_back(1);
   number_children.push_back(2);
-  path.push_back(Factorization(0));
+  path.push_back(table.Intern(Factorization(0)));
   InitToHeight(height);
 }
 
@@ -41,8 +42,15 @@ RandomWalk::RandomWalk(string filename) {
 
 void RandomWalk::NextLevel() {}
 
-void RandomWalk::RecursiveBuild(unsigned int height, Node<Factorization>* n) {
-  if (height > 0) {
+// A walk has one child per level, so it is built in a loop rather than by
+// recursion, and can be far deeper than a whole tree. The steps pushed onto
+// the table are popped in reverse at the end, as the recursion would.
+void RandomWalk::RecursiveBuild(unsigned int height, Node<FactorizationId>* n) {
+  // The composites pushed, in order, and for each level whether its step was
+  // the prime.
+  vector<Candidate> composites;
+  vector<bool> prime_steps;
+  for (; height > 0; --height) {
     // Get composites.
     vector<Candidate> candidates = table.GetCandidates();
     number_children.push_back(candidates.size() + 1);
@@ -56,29 +64,36 @@ void RandomWalk::RecursiveBuild(unsigned int height, Node<Factorization>* n) {
     
     // prime case
     if (index == candidates.size()) {
-      // Add prime and recurse
-      Node<Factorization>* child = new Node<Factorization>(
-                                           Factorization(table.GetPrimeCount()));
-      n->Add(child);
-      path.push_back(Factorization(table.GetPrimeCount()));
+      // Add prime and continue from it
+      FactorizationId prime = table.Intern(
+                                  Factorization(table.GetPrimeCount()));
+      n = AddChildInOrder(n, prime);
+      path.push_back(prime);
       number_primes[number_primes.size()-1] += 1;
       if (height > 1) {
         table.PushPrime();
-        RecursiveBuild(height - 1, child);
-        table.PopPrime();
+        prime_steps.push_back(true);
       }
     } else {  // one of the composites
-      Candidate c = candidates[index];
-      Node<Factorization>* child = new Node<Factorization>(c.GetFactors());
-      n->Add(child);
-      path.push_back(Factorization(c.GetFactors()));
+      const Candidate& c = candidates[index];
+      n = tree.AddChild(n, c.GetFactorizationId());
+      path.push_back(c.GetFactorizationId());
       if (height > 1) {
         table.PushComposite(c);
-        RecursiveBuild(height - 1, child);
-        table.PopComposite(c);
+        composites.push_back(c);
+        prime_steps.push_back(false);
       }
     }
   }
+  while (!prime_steps.empty()) {
+    if (prime_steps.back()) {
+      table.PopPrime();
+    } else {
+      table.PopComposite(composites.back());
+      composites.pop_back();
+    }
+    prime_steps.pop_back();
+  }
 }
 
 int RandomWalk::length() {
@@ -90,11 +105,11 @@ int RandomWalk::NumPrimes(int n) {
 };
 
 int RandomWalk::NumPrimeFactors(int n) {
-  return path[n].NumPrimeFactors();
+  return table.GetFactorization(path[n]).NumPrimeFactors();
 }
 
 int RandomWalk::NumDistinctPrimeFactors(int n) {
-  return path[n].NumDistinctPrimeFactors();
+  return table.GetFactorization(path[n]).NumDistinctPrimeFactors();
 }
 
 int RandomWalk::NumChildren(int n) {
@@ -102,7 +117,7 @@ int RandomWalk::NumChildren(int n) {
 }
 
 Factorization RandomWalk::GetFactorization(int n) const {
-  return path[n];
+  return table.GetFactorization(path[n]);
 }
 
 }  // namespace Platt
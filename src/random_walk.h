@@ -21,15 +21,17 @@ namespace Platt {
 
 class RandomWalk : public BeurlingTreeBase {
  private:
-  vector<Factorization> path;
+  vector<FactorizationId> path;
   vector<int> number_primes;
   vector<int> number_children;
-  void RecursiveBuild(unsigned int height, Node<Factorization>* n);
+  void RecursiveBuild(unsigned int height, Node<FactorizationId>* n);
 
  public:
   // Default Constructor initializes with just a root node.
   RandomWalk();
-  RandomWalk(unsigned int height);
+  // Solves the linear programs of each level on lp_threads threads. A walk
+  // only has one path, so this is the only way to spread it over threads.
+  RandomWalk(unsigned int height, unsigned int lp_threads = 1);
   // Construct from deserialization of a file
   RandomWalk(string filename);
   // TODO: implement NextLevel().
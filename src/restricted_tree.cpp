@@ -41,40 +41,66 @@ RestrictedTree::RestrictedTree(string filename) {
 
 void RestrictedTree::NextLevel() {}
 
+// Builds depth first like the other trees, but with an explicit stack of
+// BuildFrames instead of recursion, since a tree restricted to few composites
+// can be very deep while staying small.
 void RestrictedTree::RecursiveBuild(unsigned int height,
-                                    Node<Factorization>* n) {
-  if (height > 0) {
+                                    Node<FactorizationId>* n) {
+  vector<BuildFrame> stack;
+  // Starts the children of child, which was reached by the step pushed.
+  auto Open = [&] (Node<FactorizationId>* child, unsigned int child_height,
+                   int pushed) {
+    if (child_height == 0)
+      return;
+    stack.push_back(BuildFrame());
+    BuildFrame& frame = stack.back();
+    frame.node = child;
+    frame.height = child_height;
+    frame.pushed = pushed;
+    frame.next = 0;
+    if (max_composites == -1 || num_composites < max_composites)
+      frame.candidates = table.GetCandidates();
+  };
 
-    if (max_composites == -1 || num_composites < max_composites) {
-      // Add composites and recurse
-      vector<Candidate> candidates = table.GetCandidates();
-      for(Candidate c : candidates) {
-        Node<Factorization>* child = new Node<Factorization>(c.GetFactors());
-        n->Add(child);
-        if (height > 1) {
-          table.PushComposite(c);
-          num_composites++;
-          RecursiveBuild(height - 1, child);
-          num_composites--;
-          table.PopComposite(c);
+  Open(n, height, NO_STEP);
+  while (!stack.empty()) {
+    BuildFrame& frame = stack.back();
+    if (frame.next < frame.candidates.size()) {
+      // Add composites and descend
+      int index = frame.next++;
+      const Candidate& c = frame.candidates[index];
+      Node<FactorizationId>* child =
+          tree.AddChild(frame.node, c.GetFactorizationId());
+      if (frame.height > 1) {
+        table.PushComposite(c);
+        num_composites++;
+        Open(child, frame.height - 1, index);
+      }
+    } else if (frame.next == frame.candidates.size()) {
+      frame.next++;
+      if(max_primes == -1 || num_primes < max_primes) {
+        // Add prime among the composites and descend
+        Node<FactorizationId>* child = AddChildInOrder(
+            frame.node, table.Intern(Factorization(table.GetPrimeCount())));
+        if (frame.height > 1) {
+          table.PushPrime();
+          num_primes++;
+          Open(child, frame.height - 1, PRIME_STEP);
         }
       }
-    }
-
-    if(max_primes == -1 || num_primes < max_primes) {
-      // Add prime and recurse
-      Node<Factorization>* child = new Node<Factorization>(
-                                         Factorization(table.GetPrimeCount()));
-      n->Add(child);
-      if (height > 1) {
-        table.PushPrime();
-        num_primes++;
-        RecursiveBuild(height - 1, child);
+    } else {
+      // All the children are done: undo the step to this node.
+      int pushed = frame.pushed;
+      stack.pop_back();
+      if (pushed == PRIME_STEP) {
         num_primes--;
         table.PopPrime();
+      } else if (pushed != NO_STEP) {
+        num_composites--;
+        table.PopComposite(stack.back().candidates[pushed]);
       }
     }
   }
- }
+}
 
 }  // namespace Platt
@@ -28,7 +28,23 @@ class RestrictedTree : public BeurlingTreeBase {
   int max_composites;
   int num_primes;
   int num_composites;
-  void RecursiveBuild(unsigned int height, Node<Factorization>* n);
+
+  // A node whose children RecursiveBuild() is adding.
+  struct BuildFrame {
+    Node<FactorizationId>* node;
+    unsigned int height;
+    // The step from the parent to node: the index of a composite among the
+    // parent's candidates, PRIME_STEP, or NO_STEP for the first node.
+    int pushed;
+    vector<Candidate> candidates;
+    // The index of the next candidate to add, candidates.size() for the
+    // prime, or more when all the children are done.
+    size_t next;
+  };
+  static const int PRIME_STEP = -1;
+  static const int NO_STEP = -2;
+
+  void RecursiveBuild(unsigned int height, Node<FactorizationId>* n);
 
  public:
   // Default Constructor initializes with just a root node.
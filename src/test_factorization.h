@@ -11,6 +11,7 @@
 #define TEST_FACTORIZATION_H_
 
 #include "factorization.h"
+#include "packed_exponents.h"
 #include "compatibility.h"
 #include "test_utils.h"
 #include<string>
@@ -96,6 +97,19 @@ bool TestFactorization(string* error) {
   EXPECT_EQ(f221.RequiredCount(), (unsigned int)8, &pass, error,
                   "Required count for " + f221.ToDotString());
 
+  // Test the cached invariants.
+  EXPECT_EQ(f221.NumPrimeFactors(), 5, &pass, error,
+            "Number of prime factors of " + f221.ToDotString());
+  EXPECT_EQ(f221.NumDistinctPrimeFactors(), 3, &pass, error,
+            "Number of distinct prime factors of " + f221.ToDotString());
+  EXPECT_EQ(f221.GetMaxPrime(), 2, &pass, error,
+            "Max prime of " + f221.ToDotString());
+  EXPECT_EQ(f0.GetMaxPrime(), 0, &pass, error, "Max prime of the identity");
+  EXPECT_TRUE(f221.Hash() == Factorization(f221.ToSerialString()).Hash(),
+              &pass, error, "Equal factorizations should have equal hashes.");
+  EXPECT_TRUE(f221.Hash() != f211.Hash(), &pass, error,
+              "<2,2,1> and <2,1,1> should have different hashes.");
+
   EXPECT_TRUE((f221 == f221), &pass, error,
               "<2,2,1> should be equal to <2,2,1>.");
   EXPECT_FALSE((f221 != f221), &pass, error,
@@ -105,6 +119,54 @@ bool TestFactorization(string* error) {
   EXPECT_TRUE((f211 != f221), &pass, error,
               "<2,1,1> should be not equal to <2,1,1>.");
 
+  // Test a factorization with more distinct primes than are stored inline.
+  Factorization fwide = f211 + Factorization(3) + Factorization(4)
+                        + Factorization(5);
+  Factorization fwide_copy(fwide);
+  Factorization fwide_serial(fwide.ToSerialString());
+  EXPECT_EQ(fwide.ToSerialString(), (string)"0,2|1,1|2,1|3,1|4,1|5,1", &pass,
+            error, "Serialization of a factorization with six primes");
+  EXPECT_TRUE((fwide_copy == fwide), &pass, error,
+              "Copy of " + fwide.ToDotString() + " should be equal to it.");
+  EXPECT_TRUE((fwide_serial == fwide), &pass, error,
+              "Deserialization of " + fwide.ToDotString()
+              + " should be equal to it.");
+  EXPECT_EQ(fwide.RequiredCount(), (unsigned int)47, &pass, error,
+            "Required count for " + fwide.ToDotString());
+  EXPECT_TRUE(Factorization::LexicographicallyLess(f211, fwide), &pass, error,
+              "<2,1,1,1,1,1> should be lexicographically greater than <2,1,1>.");
+
+  // Test the packed form and the batched product kernel.
+  PackedExponents packed_row[3];
+  EXPECT_TRUE(Pack(f0, &packed_row[0]) && Pack(f211, &packed_row[1])
+              && Pack(fwide, &packed_row[2]), &pass, error,
+              "Factorizations with small primes should be packable.");
+  EXPECT_TRUE((Unpack(packed_row[2]) == fwide), &pass, error,
+              "Unpacking " + fwide.ToDotString() + " should give it back.");
+  EXPECT_TRUE((Unpack(packed_row[0]) == f0), &pass, error,
+              "Unpacking the identity should give it back.");
+  PackedExponents packed_unused;
+  EXPECT_FALSE(Pack(Factorization(PackedExponents::MAX_PRIMES),
+                    &packed_unused), &pass, error,
+               "A prime past MAX_PRIMES should not be packable.");
+  Tuple cells[2] = {Tuple(1,0), Tuple(1,1)};
+  PackedExponents packed_sums[2];
+  uint64_t packed_hashes[2];
+  EXPECT_TRUE(AddFrontierProducts(packed_row, cells, 2, 1, packed_sums,
+                                  packed_hashes), &pass, error,
+              "The frontier products should not overflow.");
+  EXPECT_TRUE((Unpack(packed_sums[0]) == f211 + f211), &pass, error,
+              "Packed product of " + f211.ToDotString() + " with itself");
+  EXPECT_TRUE((Unpack(packed_sums[1]) == f211 + fwide), &pass, error,
+              "Packed product of " + f211.ToDotString() + " and "
+              + fwide.ToDotString());
+  EXPECT_TRUE(packed_hashes[1] == HashPacked(packed_sums[1],
+                                             PackedExponents::MAX_LANES),
+              &pass, error,
+              "The hash of a packed vector should not depend on its lanes.");
+  EXPECT_FALSE(PackedEqual(packed_sums[0], packed_sums[1], 1), &pass, error,
+               "Different packed products should not be equal.");
+
   EXPECT_TRUE((Tuple(1,2) < Tuple(1,3)), &pass, error,
                 "(1,2) should be lexicographically less than (1,3).");
   EXPECT_TRUE((Tuple(1,3) < Tuple(2,1)), &pass, error,
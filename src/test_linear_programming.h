@@ -13,12 +13,19 @@
 #ifndef TEST_LINEAR_PROGRAMMING_H_
 #define TEST_LINEAR_PROGRAMMING_H_
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 #include <vector>
+#include "dense_simplex.h"
 #include "factorization.h"
+#include "feasibility_backend.h"
 #include "linear_programming.h"
+#include "linear_programming_recorder.h"
 #include "test_utils.h"
+#include "verdict_cache.h"
 using std::string;
 using std::to_string;
 using std::vector;
@@ -226,6 +233,541 @@ bool TestFailureCase(string* error) {
   return pass;
 }
 
+// The same checks as TestFailureCase(), using a LinearProgrammingContext that
+// follows the sequence as it is pushed and popped.
+bool TestContext(string* error) {
+  bool pass = true;
+  Factorization f2(0), f3(1), f4(2);
+  Factorization f5 = f2+f2, f6 = f2+f3, f7 = f3+f3, f8 = f2+f4, f9 = f2+f5;
+  Factorization f10 = f3+f4, f11 = f4+f4, f12 = f2+f6;
+
+  LinearProgrammingContext context;
+  context.Push(Factorization(), 1);
+  context.Push(f2, 1);
+  context.Push(f3, 2);
+  context.Push(f4, 3);
+  for (const Factorization& f : {f5, f6, f7, f8, f9, f10})
+    context.Push(f, 3);
+  // The rows of p_1^2 < p_1 p_2 and p_1 p_2 < p_2^2 repeat that of p_1 < p_2,
+  // and the row of p_1 p_3 < p_1^3 repeats that of p_3 < p_1^2.
+  EXPECT_EQ(context.GetStats().redundant_rows, 3ul, &pass, error,
+            "Context: three rows of the sequence should be left out.");
+  vector<const Factorization*> others(1, &f12);
+  EXPECT_FALSE(context.IsFeasible(f11, others), &pass, error,
+               "Context: p_3^2 should cause a cycle after p_2 p_3.");
+  others[0] = &f11;
+  EXPECT_TRUE(context.IsFeasible(f12, others), &pass, error,
+              "Context: p_1^2 p_2 should be feasible after p_2 p_3.");
+  // After popping back to p_1^3 the only candidate is p_2 p_3.
+  context.Pop(3);
+  others[0] = &f12;
+  EXPECT_TRUE(context.IsFeasible(f10, others), &pass, error,
+              "Context: p_2 p_3 should be feasible after p_1^3.");
+  // Popping the third prime removes its column.
+  for (int i = 0; i < 5; ++i)
+    context.Pop(3);
+  context.Pop(2);
+  others[0] = &f6;
+  EXPECT_TRUE(context.IsFeasible(f5, others), &pass, error,
+              "Context: p_1^2 should be feasible after p_2.");
+  // With three primes, all these checks are made by the cone.
+  EXPECT_EQ(context.GetStats().cone_checks, 4ul, &pass, error,
+            "Context: the cone should have made every check.");
+  return pass;
+}
+
+// Returns the factorizations of the natural numbers 1, ..., n, in order, and
+// sets num_primes[i] to the number of primes up to i + 1.
+vector<Factorization> FactorNaturalNumbers(unsigned int n,
+                                           vector<unsigned int>* num_primes) {
+  vector<Factorization> numbers(1);  // The identity.
+  vector<unsigned int> primes;
+  num_primes->assign(1, 0);
+  for (unsigned int i = 2; i <= n; ++i) {
+    vector<Tuple> factors;
+    unsigned int m = i;
+    for (unsigned int j = 0; j < primes.size(); ++j) {
+      unsigned int exponent = 0;
+      for (; m % primes[j] == 0; m /= primes[j])
+        exponent++;
+      if (exponent > 0)
+        factors.push_back(Tuple(j, exponent));
+    }
+    if (m > 1) {
+      factors.push_back(Tuple(primes.size(), 1));
+      primes.push_back(i);
+    }
+    numbers.push_back(Factorization(factors));
+    num_primes->push_back(primes.size());
+  }
+  return numbers;
+}
+
+// Checks that a check the cone cannot make is proven by the solution of an
+// earlier one, on the natural numbers up to 11, which have five primes.
+bool TestWitness(string* error) {
+  bool pass = true;
+  vector<unsigned int> num_primes;
+  vector<Factorization> numbers = FactorNaturalNumbers(12, &num_primes);
+  LinearProgrammingContext context;
+  for (unsigned int i = 0; i < 11; ++i)
+    context.Push(numbers[i], max(num_primes[i], 1u));
+  vector<const Factorization*> others;
+  EXPECT_TRUE(context.IsFeasible(numbers[11], others), &pass, error,
+              "Witness: 12 should be feasible after 11.");
+  unsigned long hits = context.GetStats().witness_hits;
+  EXPECT_TRUE(context.IsFeasible(numbers[11], others), &pass, error,
+              "Witness: 12 should still be feasible after 11.");
+  EXPECT_EQ(context.GetStats().witness_hits, hits + 1, &pass, error,
+            "Witness: the check should be proven by a witness.");
+  return pass;
+}
+
+// Checks the eviction order of a VerdictCache, and that a context with the
+// cache on answers a repeated check from it. An infeasible check is used, since
+// no witness can prove it.
+bool TestVerdictCache(string* error) {
+  bool pass = true;
+  VerdictCache cache(2);
+  ConstraintFingerprint a, b, c;
+  a.low = 1;
+  b.low = 2;
+  c.high = 1;
+  cache.Insert(a, true);
+  cache.Insert(b, false);
+  bool verdict = false;
+  EXPECT_TRUE(cache.Find(a, &verdict) && verdict, &pass, error,
+              "Verdicts: a should be cached as feasible.");
+  cache.Insert(c, true);  // Evicts b, the least recently used.
+  EXPECT_FALSE(cache.Find(b, &verdict), &pass, error,
+               "Verdicts: b should have been evicted.");
+  EXPECT_TRUE(cache.Find(a, &verdict), &pass, error,
+              "Verdicts: a should still be cached.");
+  EXPECT_TRUE(cache.Find(c, &verdict), &pass, error,
+              "Verdicts: c should be cached.");
+  cache.SetCapacity(1);
+  EXPECT_EQ(cache.Size(), 1ul, &pass, error,
+            "Verdicts: the cache should shrink to its capacity.");
+
+  // The check is decided by a certificate right after the first solve, so
+  // the verdict is only looked up once the certificate is popped.
+  vector<unsigned int> num_primes;
+  vector<Factorization> numbers = FactorNaturalNumbers(14, &num_primes);
+  LinearProgrammingContext context(16);
+  for (unsigned int i = 0; i < 11; ++i)
+    context.Push(numbers[i], max(num_primes[i], 1u));
+  // 2 * 7 cannot come before 2^2 * 3, since 2 * 3 < 7.
+  vector<const Factorization*> others(1, &numbers[11]);
+  EXPECT_FALSE(context.IsFeasible(numbers[13], others), &pass, error,
+               "Verdicts: 14 should not come before 12.");
+  context.Pop(4);
+  context.Push(numbers[10], 5);
+  EXPECT_FALSE(context.IsFeasible(numbers[13], others), &pass, error,
+               "Verdicts: 14 should still not come before 12.");
+  EXPECT_EQ(context.GetStats().verdict_hits, 1ul, &pass, error,
+            "Verdicts: the second check should be answered by the cache.");
+  EXPECT_EQ(context.GetStats().solves, 1ul, &pass, error,
+            "Verdicts: only the first check should be solved.");
+  return pass;
+}
+
+// Checks that an infeasible check leaves a certificate that decides the same
+// candidate further down the branch, and that popping drops it.
+bool TestCertificates(string* error) {
+  bool pass = true;
+  vector<unsigned int> num_primes;
+  vector<Factorization> numbers = FactorNaturalNumbers(15, &num_primes);
+  LinearProgrammingContext context;
+  for (unsigned int i = 0; i < 11; ++i)
+    context.Push(numbers[i], max(num_primes[i], 1u));
+  // 2 * 7 cannot come before 2^2 * 3, since 2 * 3 < 7.
+  vector<const Factorization*> others = {&numbers[11], &numbers[14]};
+  EXPECT_FALSE(context.IsFeasible(numbers[13], others), &pass, error,
+               "Certificates: 14 should not come before 12 and 15.");
+  EXPECT_EQ(context.GetStats().certificates, 1ul, &pass, error,
+            "Certificates: the solve should leave a certificate.");
+  // Only the row of 14 before 12 is needed, so the certificate still applies
+  // after 13, without 15.
+  context.Push(numbers[12], 6);
+  others.pop_back();
+  EXPECT_FALSE(context.IsFeasible(numbers[13], others), &pass, error,
+               "Certificates: 14 should not come before 12 after 13.");
+  EXPECT_EQ(context.GetStats().certificate_hits, 1ul, &pass, error,
+            "Certificates: the check should be decided by the certificate.");
+  // Popping 11 drops the certificate, so the check is solved again.
+  context.Pop(5);
+  context.Pop(4);
+  context.Push(numbers[10], 5);
+  EXPECT_FALSE(context.IsFeasible(numbers[13], others), &pass, error,
+               "Certificates: 14 should not come before 12 after 11.");
+  EXPECT_EQ(context.GetStats().certificate_hits, 1ul, &pass, error,
+            "Certificates: the certificate should be popped with 11.");
+  EXPECT_EQ(context.GetStats().certificates, 2ul, &pass, error,
+            "Certificates: the new solve should leave a new certificate.");
+  return pass;
+}
+
+// Records the checks of a context and reads them back.
+bool TestRecorder(string* error) {
+  bool pass = true;
+  const string filename = "test_recorder.lplog";
+  vector<unsigned int> num_primes;
+  vector<Factorization> numbers = FactorNaturalNumbers(15, &num_primes);
+  vector<const Factorization*> others = {&numbers[11], &numbers[14]};
+  vector<const Factorization*> candidates = {&numbers[11], &numbers[13]};
+  vector<bool> feasible;
+  {
+    LinearProgrammingRecorder recorder(filename);
+    LinearProgrammingContext context;
+    for (unsigned int i = 0; i < 11; ++i)
+      context.Push(numbers[i], max(num_primes[i], 1u));
+    // A second recorder throws, and must leave its file alone.
+    const string other_filename = "test_recorder_other.lplog";
+    std::ofstream(other_filename) << "kept";
+    bool threw = false;
+    try {
+      LinearProgrammingRecorder second(other_filename);
+    } catch (const std::logic_error&) {
+      threw = true;
+    }
+    EXPECT_TRUE(threw, &pass, error,
+                "Recorder: a second recorder should not be allowed.");
+    string contents;
+    std::ifstream(other_filename) >> contents;
+    std::remove(other_filename.c_str());
+    EXPECT_TRUE(contents == "kept", &pass, error,
+                "Recorder: a second recorder should not truncate its file.");
+    context.IsFeasible(numbers[13], others);
+    context.IsFeasibleBatch(candidates, &feasible);
+    context.Pop(4);
+  }
+  // The recorder is gone, so this context does not record.
+  LinearProgrammingContext unrecorded;
+  unrecorded.Push(numbers[0], 1);
+
+  LinearProgrammingLog log(filename);
+  EXPECT_TRUE(log.IsValid(), &pass, error,
+              "Recorder: the log should have a valid header.");
+  vector<LinearProgrammingRecord> records;
+  LinearProgrammingRecord record;
+  while (log.Read(&record))
+    records.push_back(record);
+  std::remove(filename.c_str());
+  EXPECT_EQ(records.size(), 14ul, &pass, error,
+            "Recorder: the log should hold 11 pushes, 2 checks and a pop.");
+  if (records.size() != 14)
+    return pass;
+  bool pushes_match = true;
+  for (unsigned int i = 0; i < 11; ++i) {
+    pushes_match &= records[i].type == PUSH_RECORD
+                    && records[i].factorizations[0] == numbers[i]
+                    && records[i].num_primes == max(num_primes[i], 1u);
+  }
+  EXPECT_TRUE(pushes_match, &pass, error,
+              "Recorder: the pushes should be read back.");
+  const LinearProgrammingRecord& single = records[11];
+  EXPECT_TRUE(single.type == CHECK_RECORD
+              && single.factorizations.size() == 3
+              && single.factorizations[0] == numbers[13]
+              && single.factorizations[2] == numbers[14]
+              && single.outcomes.size() == 1
+              && !single.outcomes[0].feasible
+              && single.outcomes[0].method == SOLVE_METHOD, &pass, error,
+              "Recorder: the check of 14 should be read back as solved.");
+  const LinearProgrammingRecord& batch = records[12];
+  EXPECT_TRUE(batch.type == CHECK_RECORD
+              && batch.factorizations.size() == 2
+              && batch.outcomes.size() == 2
+              && batch.outcomes[0].feasible == feasible[0]
+              && batch.outcomes[1].feasible == feasible[1], &pass, error,
+              "Recorder: the batch should be read back with its verdicts.");
+  EXPECT_TRUE(records[13].type == POP_RECORD && records[13].num_primes == 4,
+              &pass, error, "Recorder: the pop should be read back.");
+
+  // A corrupt record is rejected, and leaves the log invalid.
+  auto rejects = [&] (const string& body) {
+    std::ofstream(filename, std::ios::out | std::ios::binary)
+        << string("PLPR\1", 5) << body;
+    LinearProgrammingLog corrupt(filename);
+    bool rejected = !corrupt.Read(&record) && !corrupt.IsValid();
+    std::remove(filename.c_str());
+    return rejected;
+  };
+  EXPECT_TRUE(rejects(string("\3\0\xff\xff\xff\xff\x0f", 7)), &pass, error,
+              "Recorder: a check of 2^32 - 1 candidates should be rejected.");
+  EXPECT_TRUE(rejects(string("\1\0\1\1\x80\x80\x80\x80\x20\1", 10)),
+              &pass, error, "Recorder: a prime of 2^33 should be rejected.");
+  EXPECT_TRUE(rejects(string("\1\0\1\2\2\1\1\1", 8)), &pass, error,
+              "Recorder: tuples out of order should be rejected.");
+  EXPECT_TRUE(rejects(string("\2\x80\x80\x80\x80\x10\1", 7)), &pass, error,
+              "Recorder: a context of 2^32 should be rejected.");
+  return pass;
+}
+
+// Checks that a context that solves on several threads gives the same
+// verdicts, and keeps the same witnesses and certificates, as one that does
+// not, also after its workers have to catch up with pushes and pops.
+bool TestParallelBatch(string* error) {
+  bool pass = true;
+  vector<unsigned int> num_primes;
+  vector<Factorization> numbers = FactorNaturalNumbers(20, &num_primes);
+  LinearProgrammingContext serial, parallel;
+  parallel.SetNumThreads(3);
+  auto push = [&] (unsigned int n) {
+    serial.Push(numbers[n - 1], num_primes[n - 1]);
+    parallel.Push(numbers[n - 1], num_primes[n - 1]);
+  };
+  auto check = [&] (const vector<unsigned int>& candidate_numbers,
+                    const string& name) {
+    vector<const Factorization*> candidates;
+    for (unsigned int n : candidate_numbers)
+      candidates.push_back(&numbers[n - 1]);
+    vector<bool> serial_feasible, parallel_feasible;
+    serial.IsFeasibleBatch(candidates, &serial_feasible);
+    parallel.IsFeasibleBatch(candidates, &parallel_feasible);
+    EXPECT_TRUE(serial_feasible == parallel_feasible, &pass, error,
+                "Parallel: the verdicts should match " + name + ".");
+    EXPECT_EQ(parallel.GetStats().witness_hits,
+              serial.GetStats().witness_hits, &pass, error,
+              "Parallel: the witness hits should match " + name + ".");
+    EXPECT_EQ(parallel.GetStats().certificates,
+              serial.GetStats().certificates, &pass, error,
+              "Parallel: the certificates should match " + name + ".");
+    EXPECT_EQ(parallel.GetStats().solves, serial.GetStats().solves, &pass,
+              error, "Parallel: the solves should match " + name + ".");
+  };
+  push(1);
+  for (unsigned int n = 2; n <= 11; ++n)
+    push(n);
+  check({12, 14, 15, 16, 18, 20}, "after 11");
+  push(12);
+  check({14, 15, 16, 18, 20}, "after 12");
+  serial.Pop(5);
+  parallel.Pop(5);
+  serial.Pop(4);
+  parallel.Pop(4);
+  push(11);
+  push(13);
+  check({12, 14, 15, 16, 18, 20}, "after 13");
+  return pass;
+}
+
+// Checks AreFeasibleCandidates() against IsFeasibleSequence() for each
+// candidate, on the sequence of TestFailureCase().
+bool TestBatch(string* error) {
+  bool pass = true;
+  Factorization f2(0), f3(1), f4(2);
+  Factorization f5 = f2+f2, f6 = f2+f3, f7 = f3+f3, f8 = f2+f4, f9 = f2+f5;
+  Factorization f10 = f3+f4, f11 = f4+f4, f12 = f2+f6;
+  vector<Factorization> current_sequence =
+      {Factorization(), f2, f3, f4, f5, f6, f7, f8, f9};
+  vector<vector<Factorization>> candidate_sets =
+      {{f10, f12}, {f10, f11, f12}, {f11, f12}, {f12, f11, f10},
+       {f10, f12, f2+f10}, {f3+f12, f11, f12}};
+  for (const vector<Factorization>& candidates : candidate_sets) {
+    vector<bool> feasible =
+        AreFeasibleCandidates(current_sequence, candidates);
+    for (size_t k = 0; k < candidates.size(); ++k) {
+      vector<Factorization> others(candidates);
+      others.erase(others.begin() + k);
+      EXPECT_EQ((bool) feasible[k],
+                IsFeasibleSequence(current_sequence, candidates[k], others),
+                &pass, error,
+                "Batch: wrong result for " + candidates[k].ToDotString());
+    }
+  }
+  // After p_2 p_3, p_3^2 causes a cycle and p_1^2 p_2 does not.
+  current_sequence.push_back(f10);
+  vector<bool> feasible = AreFeasibleCandidates(current_sequence, {f11, f12});
+  EXPECT_FALSE(feasible[0], &pass, error,
+               "Batch: p_3^2 should cause a cycle after p_2 p_3.");
+  EXPECT_TRUE(feasible[1], &pass, error,
+              "Batch: p_1^2 p_2 should be feasible after p_2 p_3.");
+  return pass;
+}
+
+// Checks that the dominance tests reject exactly the candidates they should,
+// without solving.
+bool TestDominance(string* error) {
+  bool pass = true;
+  Factorization f2(0), f3(1), f4(2);
+  Factorization f5 = f2+f2, f6 = f2+f3, f12 = f2+f6;
+  EXPECT_TRUE(IsProperDivisor(f6, f12), &pass, error,
+              "Dominance: p_1 p_2 should divide p_1^2 p_2.");
+  EXPECT_TRUE(IsProperDivisor(Factorization(), f2), &pass, error,
+              "Dominance: 1 should divide p_1.");
+  EXPECT_FALSE(IsProperDivisor(f12, f12), &pass, error,
+               "Dominance: p_1^2 p_2 is not a proper divisor of itself.");
+  EXPECT_FALSE(IsProperDivisor(f3+f3, f12), &pass, error,
+               "Dominance: p_2^2 should not divide p_1^2 p_2.");
+  EXPECT_FALSE(IsProperDivisor(f4, f12), &pass, error,
+               "Dominance: p_3 should not divide p_1^2 p_2.");
+
+  LinearProgrammingContext context;
+  context.Push(Factorization(), 1);
+  context.Push(f2, 1);
+  context.Push(f3, 2);
+  // p_1^2 p_2 is a multiple of p_1 p_2, so it cannot come first.
+  vector<const Factorization*> candidates = {&f5, &f6, &f12};
+  vector<bool> feasible;
+  context.IsFeasibleBatch(candidates, &feasible);
+  EXPECT_FALSE(feasible[2], &pass, error,
+               "Dominance: p_1^2 p_2 should not come before p_1 p_2.");
+  EXPECT_EQ(context.GetStats().dominated_candidates, 1ul, &pass, error,
+            "Dominance: one candidate should be rejected without solving.");
+  // A single check is decided the same way, before the cone.
+  EXPECT_FALSE(context.IsFeasible(f12, {&f5, &f6}), &pass, error,
+               "Dominance: p_1^2 p_2 should not come before p_1 p_2.");
+  EXPECT_EQ(context.GetStats().dominated_candidates, 2ul, &pass, error,
+            "Dominance: the single check should also be rejected.");
+  return pass;
+}
+
+// Adds the rows of the check of candidate against others, after sequence, to
+// backend.
+void AddCheckRows(const vector<Factorization>& sequence,
+                  const Factorization& candidate,
+                  const vector<Factorization>& others,
+                  FeasibilityBackend* backend) {
+  auto add_row = [&] (const Factorization& f1, const Factorization& f2) {
+    vector<int> columns;
+    vector<double> elements;
+    for (auto p : GetConstraintCoefficients(f1, f2)) {
+      columns.push_back(p.first);
+      elements.push_back(p.second);
+    }
+    backend->AddRow(columns.size(), columns.data(), elements.data(), true);
+  };
+  for (size_t i = 0; i + 1 < sequence.size(); ++i)
+    add_row(sequence[i], sequence[i + 1]);
+  add_row(sequence.back(), candidate);
+  for (const Factorization& other : others)
+    add_row(candidate, other);
+}
+
+// Checks the dense simplex method on the checks of TestFailureCase(): its
+// answers must agree with CLP (when built with it), and its solutions must
+// satisfy every row.
+bool TestDenseSimplex(string* error) {
+  bool pass = true;
+  Factorization f2(0), f3(1), f4(2);
+  Factorization f5 = f2+f2, f6 = f2+f3, f7 = f3+f3, f8 = f2+f4, f9 = f2+f5;
+  Factorization f10 = f3+f4, f11 = f4+f4, f12 = f2+f6;
+  vector<Factorization> sequence =
+      {Factorization(), f2, f3, f4, f5, f6, f7, f8, f9, f10};
+  vector<pair<Factorization, vector<Factorization>>> checks =
+      {{f11, {f12}}, {f12, {f11}}, {f12, {}}, {f11, {}}, {f2+f12, {f12}}};
+  for (const auto& check : checks) {
+    DenseSimplexBackend dense;
+    for (int j = 0; j < 3; ++j)
+      dense.AddColumn();
+    AddCheckRows(sequence, check.first, check.second, &dense);
+    bool feasible = dense.Solve();
+#ifndef PLATT_WITHOUT_CLP
+    FeasibilityBackend* clp = NewClpBackend();
+    for (int j = 0; j < 3; ++j)
+      clp->AddColumn();
+    AddCheckRows(sequence, check.first, check.second, clp);
+    EXPECT_EQ(feasible, clp->Solve(), &pass, error,
+              "Dense simplex: disagrees with CLP for "
+              + check.first.ToDotString());
+    delete clp;
+#endif
+    if (feasible) {
+      // Every row is f1 < f2, so the weights must order the sequence, then
+      // the candidate, then the others.
+      vector<double> solution(dense.GetSolution(), dense.GetSolution() + 3);
+      auto value = [&] (const Factorization& f) {
+        double v = 0;
+        for (const Tuple& t : f.GetFactors())
+          v += t.second * solution[t.first];
+        return v;
+      };
+      vector<Factorization> order(sequence);
+      order.push_back(check.first);
+      for (size_t i = 0; i + 1 < order.size(); ++i) {
+        EXPECT_TRUE(value(order[i + 1]) - value(order[i])
+                    >= CONSTRAINT_EPSILON * (1 - 1e-9), &pass, error,
+                    "Dense simplex: the solution breaks a row of the sequence.");
+      }
+      for (const Factorization& other : check.second) {
+        EXPECT_TRUE(value(other) - value(check.first)
+                    >= CONSTRAINT_EPSILON * (1 - 1e-9), &pass, error,
+                    "Dense simplex: the solution breaks a candidate row.");
+      }
+    }
+  }
+  // A disabled row is free.
+  DenseSimplexBackend dense;
+  dense.AddColumn();
+  int column = 0;
+  double element = -1;
+  dense.AddRow(1, &column, &element, true);
+  EXPECT_FALSE(dense.Solve(), &pass, error,
+               "Dense simplex: -x >= epsilon should be infeasible.");
+  dense.SetRowEnabled(0, false);
+  EXPECT_TRUE(dense.Solve(), &pass, error,
+              "Dense simplex: a disabled row should be free.");
+  return pass;
+}
+
+// Checks that the infeasibility ray of a backend is a Farkas certificate for
+// an infeasible check of TestFailureCase(): nonnegative multipliers under which
+// the sum of the rows has no positive coefficient.
+void CheckInfeasibilityRay(FeasibilityBackend* backend, const string& name,
+                           bool* pass, string* error) {
+  Factorization f2(0), f3(1), f4(2);
+  Factorization f5 = f2+f2, f6 = f2+f3, f7 = f3+f3, f8 = f2+f4, f9 = f2+f5;
+  Factorization f10 = f3+f4, f11 = f4+f4, f12 = f2+f6;
+  vector<Factorization> sequence =
+      {Factorization(), f2, f3, f4, f5, f6, f7, f8, f9, f10};
+  for (int j = 0; j < 3; ++j)
+    backend->AddColumn();
+  AddCheckRows(sequence, f11, {f12}, backend);
+  EXPECT_FALSE(backend->Solve(), pass, error,
+               name + ": p_3^2 should not come before p_1^2 p_2.");
+  vector<double> ray;
+  EXPECT_TRUE(backend->GetInfeasibilityRay(&ray), pass, error,
+              name + ": the infeasible solve should leave a ray.");
+  EXPECT_EQ(ray.size(), (size_t) backend->NumRows(), pass, error,
+            name + ": the size of the ray");
+  if (ray.size() != (size_t) backend->NumRows())
+    return;
+  vector<pair<Factorization, Factorization>> rows;
+  for (size_t i = 0; i + 1 < sequence.size(); ++i)
+    rows.push_back({sequence[i], sequence[i + 1]});
+  rows.push_back({sequence.back(), f11});
+  rows.push_back({f11, f12});
+  vector<double> sum(3, 0.0);
+  double largest = 0;
+  for (size_t r = 0; r < rows.size(); ++r) {
+    EXPECT_TRUE(ray[r] >= -1e-9, pass, error,
+                name + ": the multipliers should be nonnegative.");
+    largest = max(largest, ray[r]);
+    for (auto p : GetConstraintCoefficients(rows[r].first, rows[r].second))
+      sum[p.first] += ray[r] * p.second;
+  }
+  EXPECT_TRUE(largest > 0, pass, error,
+              name + ": some multiplier should be positive.");
+  for (double coefficient : sum) {
+    EXPECT_TRUE(coefficient <= 1e-9 * largest, pass, error,
+                name + ": the sum of the rows should have no positive "
+                "coefficient.");
+  }
+}
+
+bool TestInfeasibilityRays(string* error) {
+  bool pass = true;
+  DenseSimplexBackend dense;
+  CheckInfeasibilityRay(&dense, "Dense ray", &pass, error);
+#ifndef PLATT_WITHOUT_CLP
+  FeasibilityBackend* clp = NewClpBackend();
+  CheckInfeasibilityRay(clp, "CLP ray", &pass, error);
+  delete clp;
+#endif
+  return pass;
+}
+
 bool TestLinearProgramming(string* error) {
   bool pass = TestGetConstraintCoefficients(error);
   if (!pass) {
@@ -236,6 +778,46 @@ bool TestLinearProgramming(string* error) {
     return pass;
   }
   pass = TestFailureCase(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestContext(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestWitness(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestVerdictCache(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestCertificates(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestParallelBatch(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestRecorder(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestBatch(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestDominance(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestDenseSimplex(error);
+  if (!pass) {
+    return pass;
+  }
+  pass = TestInfeasibilityRays(error);
   return pass;
 }
 
@@ -22,9 +22,9 @@ using std::sort;
 
 namespace Platt {
 
+// Any consistent order will do for comparing the vectors, so we order by id.
 bool LessByFactors(const Candidate& lhs, const Candidate& rhs) {
-  return Factorization::LexicographicallyLess(
-             lhs.GetFactors(), rhs.GetFactors());
+  return lhs.GetFactorizationId() < rhs.GetFactorizationId();
 }
 
 bool CandidateVectorsAreEqual(/*const*/ vector<Candidate>& lhs,
@@ -41,25 +41,123 @@ bool CandidateVectorsAreEqual(/*const*/ vector<Candidate>& lhs,
 }
 
 void TestConfiguration(bool* pass, string* error,
+                       const MultiplicationTable& table,
                        /*const*/ vector<Candidate>& expected_candidates,
                        /*const*/ vector<Candidate>& actual_candidates) {
     string error_message;
     error_message += "\nexpected candidates:\n";
     for (Candidate c: expected_candidates)
-      error_message += c.DebugString();
+      error_message += c.DebugString(table.GetPool());
     error_message += "actual candidates:\n";
     for (Candidate c: actual_candidates)
-        error_message += c.DebugString();
+        error_message += c.DebugString(table.GetPool());
 
     EXPECT_TRUE(CandidateVectorsAreEqual(
         actual_candidates, expected_candidates), pass, error,
                error_message);
 }
 
-bool TestMultiplicationTable(string* error) {
-  *error = "";
+// Pushes the natural number n onto a table that holds 1, ..., n-1, following
+// the path of the natural numbers down the tree. primes holds the primes found
+// so far (the table starts with 2) and pushed the Candidate for each number
+// pushed (with no entries for a prime). Returns false if n was not among the
+// candidates.
+bool PushNaturalNumber(unsigned int n, MultiplicationTable* table,
+                       vector<unsigned int>* primes,
+                       vector<Candidate>* pushed) {
+  vector<Tuple> factors;
+  unsigned int rest = n;
+  for (size_t i = 0; i < primes->size(); ++i) {
+    unsigned int exponent = 0;
+    for (; rest % (*primes)[i] == 0; rest /= (*primes)[i])
+      exponent++;
+    if (exponent > 0)
+      factors.push_back(Tuple(i, exponent));
+  }
+  if (rest != 1) {
+    primes->push_back(n);
+    table->PushPrime();
+    pushed->push_back(Candidate());
+    return true;
+  }
+  FactorizationId id = table->Intern(Factorization(factors));
+  for (const Candidate& c : table->GetCandidates()) {
+    if (c.GetFactorizationId() == id) {
+      table->PushComposite(c);
+      pushed->push_back(c);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Undoes the last PushNaturalNumber().
+void PopNaturalNumber(MultiplicationTable* table, vector<unsigned int>* primes,
+                      vector<Candidate>* pushed) {
+  if (pushed->back().GetEntries().empty()) {
+    primes->pop_back();
+    table->PopPrime();
+  } else {
+    table->PopComposite(pushed->back());
+  }
+  pushed->pop_back();
+}
+
+// The candidates of table, each with its cells, listed by factorization so
+// that tables with different pools can be compared.
+string CandidatesString(const MultiplicationTable& table) {
+  vector<string> lines;
+  for (Candidate c : table.GetCandidates()) {
+    vector<Tuple> entries = c.GetEntries();
+    sort(entries.begin(), entries.end());
+    string line = table.GetFactorization(c.GetFactorizationId()).ToDotString();
+    for (const Tuple& t : entries)
+      line += " (" + to_string(t.first) + "," + to_string(t.second) + ")";
+    lines.push_back(line + "\n");
+  }
+  sort(lines.begin(), lines.end());
+  string out;
+  for (const string& line : lines)
+    out += line;
+  return out;
+}
+
+// Pushes and pops the natural numbers, primes and composites, over one table.
+// After each pop, the candidates and the frontier must be those of a new table
+// that only had the remaining numbers pushed.
+bool TestMultiplicationTablePops(TableStorage storage, string* error) {
+  bool pass = true;
+  MultiplicationTable table(storage);
+  vector<unsigned int> primes(1, 2);
+  vector<Candidate> pushed;
+  // Push up to 30, pop back to 15, push up to 25 and so on.
+  const unsigned int targets[] = {30, 15, 25, 9, 12, 2};
+  unsigned int n = 2;
+  for (unsigned int target : targets) {
+    for (; n < target; ++n) {
+      EXPECT_TRUE(PushNaturalNumber(n + 1, &table, &primes, &pushed), &pass,
+                  error, to_string(n + 1) + " should be a candidate.");
+    }
+    for (; n > target; --n) {
+      PopNaturalNumber(&table, &primes, &pushed);
+      MultiplicationTable fresh_table(storage);
+      vector<unsigned int> fresh_primes(1, 2);
+      vector<Candidate> fresh_pushed;
+      for (unsigned int m = 3; m < n; ++m)
+        PushNaturalNumber(m, &fresh_table, &fresh_primes, &fresh_pushed);
+      string sequence = "1, ..., " + to_string(n - 1) + " after a pop";
+      EXPECT_EQ(CandidatesString(table), CandidatesString(fresh_table), &pass,
+                error, "Candidates for " + sequence);
+      EXPECT_EQ(table.FrontierDebugString(), fresh_table.FrontierDebugString(),
+                &pass, error, "Frontier for " + sequence);
+    }
+  }
+  return pass;
+}
+
+bool TestMultiplicationTableStorage(TableStorage storage, string* error) {
   bool pass = true;
-  MultiplicationTable table;
+  MultiplicationTable table(storage);
   Factorization f0;             // {(0,0)}
   Factorization f1(0);          // {(0,1)}
   Factorization f01(1);         // {(1,1)}
@@ -75,28 +173,28 @@ bool TestMultiplicationTable(string* error) {
 
   Candidate four;
   four.AddEntry(Tuple(1,0));  // First item on second row
-  four.SetFactors(f2);
+  four.SetFactorizationId(table.Intern(f2));
 
   Candidate six;
   six.AddEntry(Tuple(1,1));   // Second item on second row
-  six.SetFactors(f11);
+  six.SetFactorizationId(table.Intern(f11));
 
   Candidate eight;
   eight.AddEntry(Tuple(1,2)); // Third item on second row
-  eight.SetFactors(f3);
+  eight.SetFactorizationId(table.Intern(f3));
 
   Candidate nine;
   nine.AddEntry(Tuple(2,0));  // First item on third row
-  nine.SetFactors(f02);
+  nine.SetFactorizationId(table.Intern(f02));
 
   Candidate ten;
   ten.AddEntry(Tuple(1,3));   // Fourth item second row
-  ten.SetFactors(f101);
+  ten.SetFactorizationId(table.Intern(f101));
 
   Candidate twelve;
   twelve.AddEntry(Tuple(1,4));   // Fifth item on second row
   twelve.AddEntry(Tuple(2,1));   // Second item on third row
-  twelve.SetFactors(f21);
+  twelve.SetFactorizationId(table.Intern(f21));
 
   vector<Candidate> expected_candidates;
   vector<Candidate> actual_candidates;
@@ -105,19 +203,19 @@ bool TestMultiplicationTable(string* error) {
   table.PushPrime();
   expected_candidates.push_back(four);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 4 to the table
   table.PushComposite(four);
   expected_candidates.clear();
   expected_candidates.push_back(six);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 5 to the table
   table.PushPrime();
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 6 to the table
   table.PushComposite(six);
@@ -125,12 +223,12 @@ bool TestMultiplicationTable(string* error) {
   expected_candidates.push_back(eight);
   expected_candidates.push_back(nine);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 7 to the table
   table.PushPrime();
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 8 to the table
   table.PushComposite(eight);
@@ -138,22 +236,63 @@ bool TestMultiplicationTable(string* error) {
   expected_candidates.push_back(nine);
   expected_candidates.push_back(ten);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 9 to the table
   table.PushComposite(nine);
   expected_candidates.clear();
   expected_candidates.push_back(ten);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
 
   // Add the number 10 to the table
   table.PushComposite(ten);
   expected_candidates.clear();
   expected_candidates.push_back(twelve);
   actual_candidates = table.GetCandidates();
-  TestConfiguration(&pass, error, expected_candidates, actual_candidates);
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
+
+  // Remove the number 10 from the table
+  table.PopComposite(ten);
+  expected_candidates.clear();
+  expected_candidates.push_back(ten);
+  actual_candidates = table.GetCandidates();
+  TestConfiguration(&pass, error, table, expected_candidates, actual_candidates);
+
+  return pass;
+}
+
+// Both ways of storing the table must give the same candidates.
+bool TestMultiplicationTable(string* error) {
+  *error = "";
+  bool pass = TestMultiplicationTableStorage(IMPLICIT_TABLE, error);
+  pass = TestMultiplicationTableStorage(EXPLICIT_TABLE, error) && pass;
+
+  // Follow the natural numbers far enough that the explicit rows must be laid
+  // out again, and back.
+  MultiplicationTable implicit_table(IMPLICIT_TABLE);
+  MultiplicationTable explicit_table(EXPLICIT_TABLE);
+  vector<unsigned int> implicit_primes(1, 2), explicit_primes(1, 2);
+  vector<Candidate> implicit_pushed, explicit_pushed;
+  for (unsigned int n = 3; n <= 40; ++n) {
+    EXPECT_TRUE(PushNaturalNumber(n, &implicit_table, &implicit_primes,
+                                  &implicit_pushed)
+                && PushNaturalNumber(n, &explicit_table, &explicit_primes,
+                                     &explicit_pushed),
+                &pass, error, to_string(n) + " should be a candidate.");
+  }
+  EXPECT_EQ(implicit_table.DebugString(), explicit_table.DebugString(), &pass,
+            error, "Implicit and explicit tables for 1, ..., 40");
+  // Pop back to 20; 3, ..., 20 were pushed.
+  while (implicit_pushed.size() > 18)
+    PopNaturalNumber(&implicit_table, &implicit_primes, &implicit_pushed);
+  while (explicit_pushed.size() > 18)
+    PopNaturalNumber(&explicit_table, &explicit_primes, &explicit_pushed);
+  EXPECT_EQ(implicit_table.DebugString(), explicit_table.DebugString(), &pass,
+            error, "Implicit and explicit tables for 1, ..., 20");
 
+  pass = TestMultiplicationTablePops(IMPLICIT_TABLE, error) && pass;
+  pass = TestMultiplicationTablePops(EXPLICIT_TABLE, error) && pass;
   return pass;
 }
 
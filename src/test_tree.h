@@ -10,9 +10,14 @@
 #ifndef TEST_TREE_H_
 #define TEST_TREE_H_
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "tree.h"
+#include "integer_tree.h"
 #include "compatibility.h"
 using std::string;
 
@@ -25,11 +30,9 @@ bool TestTree(string* error){
   int count = 1;
 
   auto InsertItems = [&] (Node<int>* N) {
-    Node<int>* n1 = new Node<int>(count+1);
-    Node<int>* n2 = new Node<int>(count+2);
+    T.AddChild(N, count+1);
+    T.AddChild(N, count+2);
     count+=2;
-    N->Add(n1);
-    N->Add(n2);
   };
 
   auto ReadItems = [&] (Node<int>* N) {
@@ -44,6 +47,97 @@ bool TestTree(string* error){
   bool pass = (output == expected);
   if (!pass) {
     *error = "output of tree is \"" + output + "\" when it should be " + expected + "\n";
+    return pass;
+  }
+
+  // A copy has its own nodes, in its own arena.
+  Tree<int> copy(T);
+  output.clear();
+  copy.BreadthFirst(&ReadItems, copy.NO_ACTION());
+  pass = (output == expected && copy.Size() == 7
+          && copy.GetRoot() != T.GetRoot());
+  if (!pass) {
+    *error = "output of copied tree is \"" + output + "\" when it should be " + expected + "\n";
+    return pass;
+  }
+
+  // Children keep the order they were added in, and can be looked up.
+  Tree<int> ordered;
+  ordered.Init(0);
+  Node<int>* root = ordered.GetRoot();
+  for (int i = 5; i > 0; --i)
+    ordered.AddChild(root, i);
+  output.clear();
+  for (Node<int>* child : ordered.Children(root))
+    output += Platt::to_string(child->GetData());
+  pass = (output == "54321" && ordered.GetChild(root, 3) != nullptr
+          && ordered.GetChild(root, 3)->GetData() == 3
+          && !ordered.HasChild(root, 6));
+  if (!pass) {
+    *error = "children of tree are \"" + output + "\" when they should be 54321\n";
+    return pass;
+  }
+
+  // The traversals do not recurse, so a path deeper than the call stack
+  // could hold is fine.
+  struct DepthVisitor {
+    int depth = 0;
+    int max_depth = 0;
+    int leaves = 0;
+    void Enter(Node<int>* /*N*/) {max_depth = std::max(max_depth, ++depth);}
+    void Leave(Node<int>* /*N*/) {depth--;}
+    void Leaf(Node<int>* /*N*/) {leaves++;}
+  };
+  const int path_length = 1000000;
+  Tree<int> path;
+  path.Init(0);
+  Node<int>* end = path.GetRoot();
+  for (int i = 1; i < path_length; ++i)
+    end = path.AddChild(end, i);
+  path.AddChild(path.GetRoot(), -1);
+  Tree<int> path_copy(path);
+  DepthVisitor visitor;
+  path_copy.DepthFirst(visitor);
+  pass = (visitor.max_depth == path_length - 1 && visitor.depth == 0
+          && visitor.leaves == 2);
+  if (!pass) {
+    *error = "depth first visit of a path reaches depth "
+             + Platt::to_string(visitor.max_depth) + " and "
+             + Platt::to_string(visitor.leaves) + " leaves\n";
+    return pass;
+  }
+
+  // A serialized IntegerTree lists the siblings in lexicographic order, as it
+  // always has.
+  const string filename = "test_tree_serialization.txt";
+  IntegerTree integers(4);
+  integers.SerializeToFile(filename);
+  std::ifstream in_file(filename.c_str());
+  std::vector< std::vector<Factorization> > siblings(1);
+  string line;
+  int nodes = 0;
+  while (pass && std::getline(in_file, line)) {
+    if (line == "]") {
+      siblings.pop_back();
+      continue;
+    }
+    Factorization f(line.substr(0, line.size() - 1));
+    if (!siblings.back().empty()
+        && !Factorization::LexicographicallyLess(siblings.back().back(), f)) {
+      pass = false;
+      *error = "serialized tree has " + line + " after "
+               + siblings.back().back().ToSerialString() + "[\n";
+    }
+    siblings.back().push_back(f);
+    siblings.emplace_back();
+    nodes++;
+  }
+  in_file.close();
+  std::remove(filename.c_str());
+  if (pass && nodes <= 4) {
+    pass = false;
+    *error = "serialized tree of height 4 has only "
+             + Platt::to_string(nodes) + " nodes\n";
   }
   return pass;
 }
@@ -0,0 +1,60 @@
+/*
+ * thread_pool.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the ThreadPool class.
+ */
+
+#include "thread_pool.h"
+
+namespace Platt {
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+    : generation(0), running(0), stopping(false) {
+  for (unsigned int t = 0; t < num_threads; ++t)
+    threads.push_back(std::thread(&ThreadPool::ThreadMain, this, t));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  task_ready.notify_all();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+void ThreadPool::ThreadMain(unsigned int index) {
+  unsigned long last_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_ready.wait(lock, [&] {
+        return stopping || generation != last_generation;
+      });
+      if (stopping)
+        return;
+      last_generation = generation;
+    }
+    task(index);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running--;
+    }
+    task_done.notify_one();
+  }
+}
+
+void ThreadPool::Run(const std::function<void(unsigned int)>& f) {
+  std::unique_lock<std::mutex> lock(mutex);
+  task = f;
+  running = threads.size();
+  generation++;
+  task_ready.notify_all();
+  task_done.wait(lock, [&] {return running == 0;});
+}
+
+}  // namespace Platt
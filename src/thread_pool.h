@@ -0,0 +1,60 @@
+/*
+ * thread_pool.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the ThreadPool class, a fixed set of threads that run one task
+ *  each per call of Run(). It is used to run the checks of a
+ *  LinearProgrammingContext in parallel (see linear_programming.h).
+ *
+ *  Each call of Run() hands thread t the task index t, so the work a thread
+ *  does only depends on how the caller splits it by that index, never on
+ *  timing. That keeps the results deterministic.
+ */
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using std::vector;
+
+namespace Platt {
+
+class ThreadPool {
+ private:
+  vector<std::thread> threads;
+  std::mutex mutex;
+  // Signals the threads that a new task is ready, or that they should stop.
+  std::condition_variable task_ready;
+  // Signals the caller of Run() that all the threads are done.
+  std::condition_variable task_done;
+  std::function<void(unsigned int)> task;
+  // Incremented for each call of Run(), so a thread can tell a new task from
+  // the one it has just run.
+  unsigned long generation;
+  unsigned int running;
+  bool stopping;
+
+  void ThreadMain(unsigned int index);
+
+ public:
+  explicit ThreadPool(unsigned int num_threads);
+  // Waits for the threads to finish.
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned int NumThreads() const {return threads.size();}
+  // Calls f(t) on thread t, for every thread, and returns once all the calls
+  // have returned. f must not throw.
+  void Run(const std::function<void(unsigned int)>& f);
+};
+
+}  // namespace Platt
+
+#endif /* THREAD_POOL_H_ */
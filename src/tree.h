@@ -5,9 +5,17 @@
  *      Author: Devin
  *
  *  A tree designed specifically for the Beurling tree program. It has no node
- *  insertion/deletion or search functions. For our purposes, a functor is a
- *  functor that takes Node* as its parameter and must have an operator which
- *  takes the argument: Node<T>* N".
+ *  deletion functions, and its only search is GetChild(). For our purposes, a
+ *  functor is a functor that takes Node* as its parameter and must have an
+ *  operator which takes the argument: Node<T>* N". A visitor is a class with
+ *  the members Enter(), Leave() and Leaf() of DepthFirst(), all taking a
+ *  Node<T>* N; its type is known when DepthFirst() is compiled, so its members
+ *  are called directly.
+ *
+ *  The tree owns its nodes through a NodeArena: make them with Init() and
+ *  AddChild(). They are all freed together, with the tree. The children of a
+ *  node are kept in the order they were added, or in the caller's order with
+ *  InsertChild().
  *
  *  Unfortunately due to templating we must include implementation in the
  *  header file.
@@ -16,124 +24,252 @@
 #ifndef TREE_H_
 #define TREE_H_
 
-#include <queue>
+#include <utility>
+#include <vector>
 #include "node.h"
-using std::queue;
+#include "node_arena.h"
+using std::vector;
 
 namespace Platt {
 
 template <class T>
 class Tree {
  private:
+  NodeArena<T> arena;
   Node<T>* root;
 
-  // We define some functors for use with the Iterate method of Node.
-
-  class CopyFunctor {
-   private:
-    Node<T>* current;
+  // A frame of the explicit stack of DepthFirst(): a node whose children are
+  // being visited, and the next of them.
+  struct DfsFrame {
+    Node<T>* node;
+    NodeHandle next_child;
+  };
+  // The stack of DepthFirst(), kept between calls so that its memory is
+  // reused.
+  vector<DfsFrame> dfs_stack;
 
+  class BlankFunctor {
    public:
-    CopyFunctor() {current = nullptr;}
-    CopyFunctor(Node<T>* in) {
-      current = in;
-    }
-
-    CopyFunctor(const CopyFunctor& c){current = c.current;}
-
-    void operator() (Node<T>* N) {
-      Node<T>* temp = new Node<T>( N->GetData() );
-      current->Add(temp);
-      CopyFunctor c(temp);
-      N->Iterate(c);
-    }
+    BlankFunctor(){}
+    void operator() (Node<T>* N){}
   };
 
-  template <class Rec1, class Rec2, class Leaf>
-  class DfsFunctor {
+  // Calls f on N, unless f was given as NO_ACTION.
+  template <class functor>
+  static void CallIfSet(functor* f, Node<T>* N) {
+    if (f) {(*f)(N);}
+  }
+  static void CallIfSet(BlankFunctor* /*f*/, Node<T>* /*N*/) {}
+
+  // Adapts three functor pointers to a visitor for DepthFirst().
+  template <class Rec1, class Rec2, class LeafFunctor>
+  class FunctorVisitor {
    private:
     Rec1* r1;
     Rec2* r2;
-    Leaf* l;
+    LeafFunctor* l;
 
    public:
-    DfsFunctor() {r1 = nullptr; r2 = nullptr; l = nullptr;}
-    DfsFunctor(Rec1* R1, Rec2* R2, Leaf* L) {
-      r1=R1;
-      r2=R2;
-      l=L;
-    }
-
-    DfsFunctor(const DfsFunctor& R) {
-      r1=R.r1;
-      r2=R.r2;
-      l=R.l;
-    }
-
-    void operator() (Node<T>* current) {
-      if( !current->Childless() ) {  // if not at leaf
-        if (r1) {(*r1)( current );}
-        current->Iterate ( *this );
-        if (r2) {(*r2)( current );}
-      }
-      else  // else at leaf
-        (*l)( current );
-    }
-  };
-
-  class BlankFunctor {
-   public:
-    BlankFunctor(){}
-    void operator() (Node<T>* N){}
+    FunctorVisitor(Rec1* R1, Rec2* R2, LeafFunctor* L)
+        : r1(R1), r2(R2), l(L) {}
+    void Enter(Node<T>* N) {CallIfSet(r1, N);}
+    void Leave(Node<T>* N) {CallIfSet(r2, N);}
+    void Leaf(Node<T>* N) {CallIfSet(l, N);}
   };
 
  public:
   Tree(){root = 0;}
   Tree(const Tree<T>& in) {
-    Tree();
+    root = 0;
     *this = in;
   }
 
   const Tree<T>& operator = ( const Tree& in ) {
+    if (this == &in)
+      return in;
+    arena.Clear();
+    root = 0;
     if (in.root != 0) {
-      root = new Node<T>(in.root->GetData());
-      CopyFunctor c(root);
-      in.root->Iterate(c);
+      root = arena.Get(arena.New(in.root->GetData()));
+      // Pairs of a node of in and its copy, whose children are still to be
+      // copied.
+      vector< std::pair<const Node<T>*, Node<T>*> > stack;
+      stack.emplace_back(in.root, root);
+      while (!stack.empty()) {
+        const Node<T>* from = stack.back().first;
+        Node<T>* to = stack.back().second;
+        stack.pop_back();
+        for (const Node<T>* child : in.Children(from))
+          stack.emplace_back(child, AddChild(to, child->GetData()));
+      }
     }
     return in;
   }
 
-  // Initialize with root value
+  // Initialize with root value. Any nodes the tree had are freed.
   void Init(T data) {
-    Node<T>* N = new Node<T>(data);
-    root = N;
+    arena.Clear();
+    root = arena.Get(arena.New(data));
+  }
+
+  // Adds a new node holding data as the last child of parent, and returns it.
+  Node<T>* AddChild(Node<T>* parent, const T& data) {
+    NodeHandle handle = arena.New(data);
+    if (parent->first_child == NO_NODE)
+      parent->first_child = handle;
+    else
+      arena.Get(parent->last_child)->next_sibling = handle;
+    parent->last_child = handle;
+    return arena.Get(handle);
+  }
+
+  // Adds a new node holding data as a child of parent, before its first child
+  // c with less(data, c's data), or last if there is none, and returns it.
+  // Children that were added in the order of less stay in it.
+  template <class Less>
+  Node<T>* InsertChild(Node<T>* parent, const T& data, Less less) {
+    NodeHandle previous = NO_NODE;
+    NodeHandle next = parent->first_child;
+    while (next != NO_NODE && !less(data, arena.Get(next)->GetData())) {
+      previous = next;
+      next = arena.Get(next)->next_sibling;
+    }
+    if (next == NO_NODE)
+      return AddChild(parent, data);
+    NodeHandle handle = arena.New(data);
+    arena.Get(handle)->next_sibling = next;
+    if (previous == NO_NODE)
+      parent->first_child = handle;
+    else
+      arena.Get(previous)->next_sibling = handle;
+    return arena.Get(handle);
   }
 
-  // The behavior of this function is unexpected if the functors modify the
-  // "nodes" field of any nodes.
+  // Returns the first child of n holding data, or nullptr if there is none.
+  // The children are searched in turn, which is fine for the few that a node
+  // has.
+  Node<T>* GetChild(const Node<T>* n, const T& data) const {
+    for (Node<T>* child : Children(n)) {
+      if (child->GetData() == data)
+        return child;
+    }
+    return nullptr;
+  }
+  bool HasChild(const Node<T>* n, const T& data) const {
+    return GetChild(n, data) != nullptr;
+  }
+
+  // Iterates over the children of a node, in order.
+  class ChildIterator {
+   private:
+    const NodeArena<T>* arena;
+    NodeHandle handle;
+
+   public:
+    ChildIterator(const NodeArena<T>* a, NodeHandle h) : arena(a), handle(h) {}
+    Node<T>* operator*() const {return arena->Get(handle);}
+    ChildIterator& operator++() {
+      handle = arena->Get(handle)->next_sibling;
+      return *this;
+    }
+    bool operator==(const ChildIterator& rhs) const {
+      return handle == rhs.handle;
+    }
+    bool operator!=(const ChildIterator& rhs) const {
+      return handle != rhs.handle;
+    }
+  };
+
+  // The children of a node, for a range-based for. It allocates nothing, and
+  // stays valid while children are added elsewhere in the tree.
+  class ChildRange {
+   private:
+    ChildIterator first;
+
+   public:
+    explicit ChildRange(ChildIterator f) : first(f) {}
+    ChildIterator begin() const {return first;}
+    ChildIterator end() const {return ChildIterator(nullptr, NO_NODE);}
+  };
+
+  ChildRange Children(const Node<T>* n) const {
+    return ChildRange(ChildIterator(&arena, n->first_child));
+  }
+
+  // The number of nodes in the tree.
+  NodeHandle Size() const {return arena.Size();}
+
+  // Calls p on each node, level by level, and c on each child of it. The
+  // behavior of this function is unexpected if the functors add children to
+  // nodes that have not been visited yet.
   template <class parent_functor, class child_functor>
   void BreadthFirst(parent_functor* p, child_functor* c) {
-    queue< Node<T>* > q;
-    Node<T>* temp;
-    auto EnqueueFunc = [&] (Node<T>* N) {q.push(N);};
-
-    q.push(root);
-
-    // Note: the functors should not alter the "nodes" fields of the nodes.
-    while (!q.empty()) {
-      temp = q.front();
-      q.pop();
-      if (p) {(*p)(temp);}
-      if (c) {temp->Iterate(*c);}
-      temp->Iterate( EnqueueFunc ); // enqueue all of the children
+    // The queue is the part of the vector from front on.
+    vector< Node<T>* > q;
+    q.push_back(root);
+    for (size_t front = 0; front < q.size(); ++front) {
+      Node<T>* temp = q[front];
+      CallIfSet(p, temp);
+      for (Node<T>* child : Children(temp)) {
+        CallIfSet(c, child);
+        q.push_back(child);  // enqueue all of the children
+      }
     }
   }
 
-  // Follows a depth first path and takes actions at different steps.
+  // Follows a depth first path and takes actions at different steps, given as
+  // the members of visitor:
+  //   Enter(Node<T>* N)  before the children of N, if it has any,
+  //   Leave(Node<T>* N)  after the children of N, if it has any,
+  //   Leaf(Node<T>* N)   if N has no children.
+  // The path is followed with an explicit stack, so the depth of the tree is
+  // not limited by the call stack, and the visitor's members can be inlined.
+  // The stack is reused from the last call, so once ReserveDepth() has been
+  // called with the depth of the tree, the traversal itself allocates nothing.
+  // Leaf() may add children to N; they are not visited.
+  template <class Visitor>
+  void DepthFirst(Visitor& visitor) {
+    if (root->Childless()) {
+      visitor.Leaf(root);
+      return;
+    }
+    visitor.Enter(root);
+    // Taken from dfs_stack, so that a traversal started by the visitor gets
+    // a stack of its own.
+    vector<DfsFrame> stack;
+    stack.swap(dfs_stack);
+    stack.clear();
+    stack.push_back(DfsFrame{root, root->first_child});
+    while (!stack.empty()) {
+      DfsFrame& top = stack.back();
+      if (top.next_child == NO_NODE) {
+        Node<T>* N = top.node;
+        stack.pop_back();
+        visitor.Leave(N);
+        continue;
+      }
+      Node<T>* child = arena.Get(top.next_child);
+      top.next_child = child->next_sibling;
+      if (child->Childless()) {
+        visitor.Leaf(child);
+      } else {
+        visitor.Enter(child);
+        stack.push_back(DfsFrame{child, child->first_child});
+      }
+    }
+    dfs_stack.swap(stack);
+  }
+
+  // Makes room for DepthFirst() to visit a tree with paths of up to depth
+  // nodes without allocating.
+  void ReserveDepth(size_t depth) {dfs_stack.reserve(depth);}
+
+  // The same, with the actions given as functors: r1 for Enter(), r2 for
+  // Leave() and l for Leaf(). Any of them may be NO_ACTION().
   template <class Rec1, class Rec2, class leaf>
   void DepthFirst(Rec1* r1, Rec2* r2, leaf* l) {
-    DfsFunctor<Rec1,Rec2,leaf> d(r1,r2,l);
-    d(root);
+    FunctorVisitor<Rec1,Rec2,leaf> visitor(r1,r2,l);
+    DepthFirst(visitor);
   };
 
   // This is useful when the generic algorithms (DFS, BFS) still don't cut it.
@@ -143,13 +279,8 @@ class Tree {
   // algorithm.
   BlankFunctor* NO_ACTION() {return nullptr;}
 
-  ~Tree(){
-    auto DeleteAfterChildren = [] (Node<T>* N) {delete N;};
-    auto DeleteLeaf = [] (Node<T>* N) {delete N;};
-
-    if(root != 0)
-      DepthFirst(NO_ACTION() , &DeleteAfterChildren, &DeleteLeaf);
-  }
+  // The arena frees the nodes.
+  ~Tree() {}
 };
 
 }  // namespace Platt
@@ -0,0 +1,159 @@
+/*
+ * tuple_vector.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares and defines the TupleVector class, the storage used for the
+ *  (prime, exponent) Tuples of a Factorization.
+ *
+ *  Almost every factorization we see has only a handful of distinct prime
+ *  factors, so the Tuples are stored inline in the object itself. Only when a
+ *  factorization has more than INLINE_CAPACITY distinct primes do we fall back
+ *  to a heap allocated array. This means that building a tree no longer
+ *  requires a heap allocation for every factorization in the table, in the
+ *  candidates, and in the nodes of the tree.
+ *
+ *  Only the small subset of the std::vector interface that the program needs
+ *  is provided. Implementation is inlined in the header since it is short.
+ */
+
+#ifndef TUPLE_VECTOR_H_
+#define TUPLE_VECTOR_H_
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+using std::pair;
+using std::uninitialized_copy;
+using std::vector;
+
+namespace Platt {
+
+// Note that "std::tuple" is a type!
+// A Tuple is a (prime, exponent) pair.
+typedef pair<unsigned int, unsigned int> Tuple;
+
+// Tuples are never destroyed explicitly, so storage can simply be reused.
+static_assert(std::is_trivially_destructible<Tuple>::value,
+              "TupleVector requires trivially destructible Tuples");
+
+class TupleVector {
+ public:
+  // The number of Tuples stored without a heap allocation.
+  static const unsigned int INLINE_CAPACITY = 4;
+
+ private:
+  unsigned int length;
+  // A capacity greater than INLINE_CAPACITY means that heap_tuples is in use.
+  unsigned int capacity;
+  // Raw storage: the first length Tuples are constructed with placement new.
+  typedef std::aligned_storage<sizeof(Tuple), alignof(Tuple)>::type
+      TupleStorage;
+  union {
+    TupleStorage inline_tuples[INLINE_CAPACITY];
+    Tuple* heap_tuples;
+  };
+
+  bool OnHeap() const {return capacity > INLINE_CAPACITY;}
+
+  // Moves the Tuples to raw heap storage that can hold at least new_capacity
+  // Tuples.
+  void Grow(unsigned int new_capacity) {
+    Tuple* grown =
+        static_cast<Tuple*>(::operator new(new_capacity * sizeof(Tuple)));
+    uninitialized_copy(begin(), end(), grown);
+    if (OnHeap())
+      ::operator delete(heap_tuples);
+    heap_tuples = grown;
+    capacity = new_capacity;
+  }
+
+  void CopyFrom(const TupleVector& v) {
+    if (v.length > capacity)
+      Grow(v.length);
+    uninitialized_copy(v.begin(), v.end(), begin());
+    length = v.length;
+  }
+
+  // Takes the heap array from v, if it has one, so that no copy is made.
+  // Otherwise v fits inline, so the copy never grows and cannot throw.
+  void MoveFrom(TupleVector& v) noexcept {
+    if (v.OnHeap()) {
+      if (OnHeap())
+        ::operator delete(heap_tuples);
+      heap_tuples = v.heap_tuples;
+      capacity = v.capacity;
+      length = v.length;
+      v.capacity = INLINE_CAPACITY;
+      v.length = 0;
+    } else {
+      CopyFrom(v);
+    }
+  }
+
+ public:
+  TupleVector() : length(0), capacity(INLINE_CAPACITY) {}
+  TupleVector(const vector<Tuple>& tuples)
+      : length(0), capacity(INLINE_CAPACITY) {
+    reserve(tuples.size());
+    for (const Tuple& t : tuples)
+      push_back(t);
+  }
+  TupleVector(const TupleVector& v) : length(0), capacity(INLINE_CAPACITY) {
+    CopyFrom(v);
+  }
+  TupleVector(TupleVector&& v) noexcept
+      : length(0), capacity(INLINE_CAPACITY) {
+    MoveFrom(v);
+  }
+  TupleVector& operator=(const TupleVector& v) {
+    if (this != &v)
+      CopyFrom(v);
+    return *this;
+  }
+  TupleVector& operator=(TupleVector&& v) noexcept {
+    if (this != &v)
+      MoveFrom(v);
+    return *this;
+  }
+  ~TupleVector() {
+    if (OnHeap())
+      ::operator delete(heap_tuples);
+  }
+
+  size_t size() const {return length;}
+  bool empty() const {return length == 0;}
+  void clear() {length = 0;}
+  void reserve(size_t n) {
+    if (n > capacity)
+      Grow(n);
+  }
+  void push_back(const Tuple& t) {
+    if (length == capacity)
+      Grow(2 * capacity);
+    new (begin() + length) Tuple(t);
+    ++length;
+  }
+
+  Tuple* begin() {
+    return OnHeap() ? heap_tuples : reinterpret_cast<Tuple*>(inline_tuples);
+  }
+  Tuple* end() {return begin() + length;}
+  const Tuple* begin() const {
+    return OnHeap() ? heap_tuples
+                    : reinterpret_cast<const Tuple*>(inline_tuples);
+  }
+  const Tuple* end() const {return begin() + length;}
+  Tuple& operator[](size_t i) {return begin()[i];}
+  const Tuple& operator[](size_t i) const {return begin()[i];}
+  const Tuple& back() const {return begin()[length - 1];}
+
+  vector<Tuple> ToVector() const {return vector<Tuple>(begin(), end());}
+};
+
+}  // namespace Platt
+
+#endif /* TUPLE_VECTOR_H_ */
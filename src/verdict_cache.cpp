@@ -0,0 +1,56 @@
+/*
+ * verdict_cache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Defines the VerdictCache class.
+ */
+
+#include "verdict_cache.h"
+#include <iterator>
+
+namespace Platt {
+
+VerdictCache::VerdictCache(size_t capacity) : capacity(capacity) {}
+
+void VerdictCache::SetCapacity(size_t new_capacity) {
+  capacity = new_capacity;
+  while (entries.size() > capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+}
+
+bool VerdictCache::Find(const ConstraintFingerprint& fingerprint,
+                        bool* verdict) {
+  auto it = index.find(fingerprint);
+  if (it == index.end())
+    return false;
+  entries.splice(entries.begin(), entries, it->second);
+  *verdict = it->second->second;
+  return true;
+}
+
+void VerdictCache::Insert(const ConstraintFingerprint& fingerprint,
+                          bool verdict) {
+  if (capacity == 0)
+    return;
+  auto it = index.find(fingerprint);
+  if (it != index.end()) {
+    it->second->second = verdict;
+    entries.splice(entries.begin(), entries, it->second);
+    return;
+  }
+  if (entries.size() == capacity) {
+    // Reuse the node of the least recently used entry.
+    index.erase(entries.back().first);
+    entries.splice(entries.begin(), entries, std::prev(entries.end()));
+    entries.front() = std::make_pair(fingerprint, verdict);
+  } else {
+    entries.emplace_front(fingerprint, verdict);
+  }
+  index[fingerprint] = entries.begin();
+}
+
+}  // namespace Platt
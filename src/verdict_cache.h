@@ -0,0 +1,77 @@
+/*
+ * verdict_cache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: Devin
+ *
+ *  Declares the VerdictCache class, a bounded cache of the verdicts of
+ *  feasibility checks, and the ConstraintFingerprint that keys it.
+ *
+ *  The same system of constraints is often checked again along a branch of a
+ *  tree: at a sibling reached by pushing a new prime, whose weight only
+ *  appears in rows that it can satisfy on its own, and when
+ *  PrimePowerTree::RecursiveBuildContinue() explores the same composites
+ *  again. The LinearProgrammingContext reduces each system to the rows that
+ *  matter (see LinearProgrammingContext::Fingerprint()) and looks up the
+ *  fingerprint of what is left before solving it.
+ *
+ *  The least recently used verdict is evicted when the cache is full.
+ */
+
+#ifndef VERDICT_CACHE_H_
+#define VERDICT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+using std::list;
+using std::pair;
+using std::unordered_map;
+
+namespace Platt {
+
+// A 128-bit hash of a set of constraint rows, made of two independent 64-bit
+// hashes, so that two different systems practically never share one.
+struct ConstraintFingerprint {
+  uint64_t low;
+  uint64_t high;
+
+  ConstraintFingerprint() : low(0), high(0) {}
+  bool operator==(const ConstraintFingerprint& other) const {
+    return low == other.low && high == other.high;
+  }
+};
+
+struct ConstraintFingerprintHash {
+  size_t operator()(const ConstraintFingerprint& fingerprint) const {
+    return fingerprint.low;
+  }
+};
+
+class VerdictCache {
+ private:
+  size_t capacity;
+  // The most recently used entry comes first.
+  list<pair<ConstraintFingerprint, bool>> entries;
+  unordered_map<ConstraintFingerprint,
+                list<pair<ConstraintFingerprint, bool>>::iterator,
+                ConstraintFingerprintHash> index;
+
+ public:
+  explicit VerdictCache(size_t capacity);
+
+  size_t GetCapacity() const {return capacity;}
+  // Evicts the least recently used verdicts down to the new capacity. A
+  // capacity of 0 turns the cache off.
+  void SetCapacity(size_t new_capacity);
+  size_t Size() const {return entries.size();}
+  // Sets *verdict and returns true if the verdict for fingerprint is cached.
+  bool Find(const ConstraintFingerprint& fingerprint, bool* verdict);
+  void Insert(const ConstraintFingerprint& fingerprint, bool verdict);
+};
+
+}  // namespace Platt
+
+#endif /* VERDICT_CACHE_H_ */